@@ -0,0 +1,288 @@
+#include "AnalysisEngine.h"
+
+AnalysisEngine::AnalysisEngine(AudioPluginAudioProcessor &processor) : processorRef(processor),
+                                                                        smoothingParameter(processor.apvts.getRawParameterValue("Analyzer Smoothing"))
+{
+    leftChannelFFTDataGenerator.changeOrder(AnalyzerGovernor::getQuality(0).order);
+    monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+    monoBuffer.clear();
+
+    prepareCoefficients(responseChain);
+}
+
+AnalysisEngine::~AnalysisEngine()
+{
+    stop();
+}
+
+void AnalysisEngine::start()
+{
+    if (!isRunning)
+        workerPool->addClient(*this);
+
+    isRunning = true;
+}
+
+void AnalysisEngine::stop()
+{
+    if (isRunning)
+        workerPool->removeClient(*this);
+
+    isRunning = false;
+}
+
+std::shared_ptr<const AnalysisSnapshot> AnalysisEngine::getLatestSnapshot() const
+{
+    return std::atomic_load(&latestSnapshot);
+}
+
+void AnalysisEngine::processNextFrame()
+{
+    EQ_TRACE_SCOPE("AnalysisEngine::processNextFrame");
+
+    auto frameStartMs = juce::Time::getMillisecondCounterHiRes();
+    auto sampleRate = 0.0;
+
+    // The FIFO is drained every frame, skipped or not, since it only holds a couple of
+    // frames worth of blocks and would start dropping the newest ones. prepareToPlay
+    // re-prepares it under the same lock.
+    {
+        const juce::ScopedLock sl(processorRef.analyzerFifoLock);
+        auto &leftChannelFifo = processorRef.leftChannelFifo;
+
+        sampleRate = processorRef.getAnalysisSampleRate();
+
+        // Nothing to analyse until the host has prepared the processor
+        if (sampleRate <= 0.0 || !leftChannelFifo.isPrepared())
+            return;
+
+        FrameTimeHistogram::ScopedTimer timer(&frameTimings[FrameTimings::fifoDrain]);
+
+        while (leftChannelFifo.getNumCompleteBuffersAvailable() > 0)
+        {
+            if (leftChannelFifo.getAudioBuffer(incomingBuffer))
+            {
+                auto size = juce::jmin(incomingBuffer.getNumSamples(), monoBuffer.getNumSamples());
+
+                juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0), monoBuffer.getReadPointer(0, size),
+                                                  monoBuffer.getNumSamples() - size);
+
+                juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
+                                                  incomingBuffer.getReadPointer(0, incomingBuffer.getNumSamples() - size), size);
+
+                auto *samples = incomingBuffer.getReadPointer(0);
+
+                for (int i = 0; i < incomingBuffer.getNumSamples(); i++)
+                {
+                    pendingPeak = juce::jmax(pendingPeak, std::abs(samples[i]));
+                    pendingSumOfSquares += (double)samples[i] * samples[i];
+                }
+
+                pendingNumSamples += incomingBuffer.getNumSamples();
+                samplesSinceLastFFT += incomingBuffer.getNumSamples();
+            }
+        }
+    }
+
+    auto level = governor.update(processorRef.getAudioLoad(), processorRef.getNumAudioOverruns(),
+                                 lastFrameMilliseconds, frameStartMs);
+    const auto &quality = AnalyzerGovernor::getQuality(level);
+
+    if (--framesUntilNextRun > 0)
+        return;
+
+    framesUntilNextRun = quality.frameDivisor;
+
+    if (quality.order != leftChannelFFTDataGenerator.getOrder())
+        changeOrder(quality.order);
+
+    auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
+    auto newDataAvailable = pendingNumSamples > 0;
+    auto spectrumDue = newDataAvailable && samplesSinceLastFFT >= fftSize / quality.overlap;
+
+    auto previous = getLatestSnapshot();
+    auto chainSettings = getChainSettings(processorRef.apvts);
+    auto responseChanged = chainSettings != lastChainSettings || sampleRate != lastSampleRate || previous == nullptr;
+    auto qualityChanged = previous != nullptr && previous->qualityLevel != level;
+
+    if (!newDataAvailable && !responseChanged && !qualityChanged)
+    {
+        lastFrameMilliseconds = juce::Time::getMillisecondCounterHiRes() - frameStartMs;
+        return;
+    }
+
+    // Published snapshots are immutable, so each frame gets a new one, carrying over
+    // whatever didn't change
+    auto snapshot = previous != nullptr ? std::make_shared<AnalysisSnapshot>(*previous)
+                                        : std::make_shared<AnalysisSnapshot>();
+
+    snapshot->frameIndex++;
+    snapshot->sampleRate = sampleRate;
+    snapshot->qualityLevel = level;
+
+    if (newDataAvailable)
+    {
+        snapshot->peakDecibels = juce::Decibels::gainToDecibels(pendingPeak);
+        snapshot->rmsDecibels = (float)juce::Decibels::gainToDecibels(std::sqrt(pendingSumOfSquares / pendingNumSamples));
+
+        pendingPeak = 0.0f;
+        pendingSumOfSquares = 0.0;
+        pendingNumSamples = 0;
+    }
+
+    if (spectrumDue)
+    {
+        auto choice = juce::jlimit(0, (int)std::size(analyzerSmoothingChoices) - 1, (int)smoothingParameter->load());
+        leftChannelFFTDataGenerator.setSmoothing(analyzerSmoothingChoices[choice]);
+
+        {
+            FrameTimeHistogram::ScopedTimer timer(&frameTimings[FrameTimings::fft]);
+            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -96.0f);
+        }
+
+        samplesSinceLastFFT = 0;
+
+        if (leftChannelFFTDataGenerator.acquireFFTData())
+        {
+            const auto &fftData = leftChannelFFTDataGenerator.getFFTData();
+            snapshot->fftSize = fftSize;
+            snapshot->spectrum.assign(fftData.begin(), fftData.begin() + fftSize / 2);
+            snapshot->smoothingBandsPerOctave = leftChannelFFTDataGenerator.getSmoothing();
+            snapshot->spectrumIndex++;
+        }
+    }
+
+    if (responseChanged)
+    {
+        FrameTimeHistogram::ScopedTimer timer(&frameTimings[FrameTimings::responseUpdate]);
+
+        updateResponseChain(chainSettings, sampleRate);
+        computeResponse(snapshot->response, sampleRate);
+        snapshot->responseIndex++;
+
+        lastChainSettings = chainSettings;
+        lastSampleRate = sampleRate;
+    }
+
+    {
+        const juce::ScopedLock sl(publisherLock);
+        publisher.publish(*snapshot);
+    }
+
+    std::atomic_store(&latestSnapshot, std::shared_ptr<const AnalysisSnapshot>(std::move(snapshot)));
+
+    lastFrameMilliseconds = juce::Time::getMillisecondCounterHiRes() - frameStartMs;
+}
+
+// Keeps the newest samples, so the next spectrum doesn't start from silence
+void AnalysisEngine::changeOrder(FFTOrder newOrder)
+{
+    leftChannelFFTDataGenerator.changeOrder(newOrder);
+
+    auto newSize = leftChannelFFTDataGenerator.getFFTSize();
+    auto numToKeep = juce::jmin(newSize, monoBuffer.getNumSamples());
+
+    juce::AudioBuffer<float> resized(1, newSize);
+    resized.clear();
+    resized.copyFrom(0, newSize - numToKeep, monoBuffer, 0, monoBuffer.getNumSamples() - numToKeep, numToKeep);
+
+    monoBuffer = std::move(resized);
+}
+
+bool AnalysisEngine::setSharedMemoryExportEnabled(bool shouldBeEnabled)
+{
+    const juce::ScopedLock sl(publisherLock);
+
+    if (shouldBeEnabled == publisher.isOpen())
+        return true;
+
+    if (!shouldBeEnabled)
+    {
+        publisher.close();
+        return true;
+    }
+
+    return publisher.open();
+}
+
+bool AnalysisEngine::isSharedMemoryExportEnabled() const
+{
+    const juce::ScopedLock sl(publisherLock);
+    return publisher.isOpen();
+}
+
+juce::String AnalysisEngine::getSharedMemoryName() const
+{
+    const juce::ScopedLock sl(publisherLock);
+    return publisher.getName();
+}
+
+void AnalysisEngine::updateResponseChain(const ChainSettings &chainSettings, double sampleRate)
+{
+    responseChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+    responseChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+    responseChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+
+    designPeakFilter(responseChain.get<ChainPositions::Peak>(), chainSettings, sampleRate);
+    auto design = getEffectiveDesign(chainSettings);
+
+    designCutFilter(responseChain.get<ChainPositions::LowCut>(), chainSettings.lowCutFreq, chainSettings.lowCutSlope, sampleRate, true, design);
+    designCutFilter(responseChain.get<ChainPositions::HighCut>(), chainSettings.highCutFreq, chainSettings.highCutSlope, sampleRate, false, design);
+}
+
+template <typename ChainType>
+double getCutMagnitudeForFrequency(const ChainType &cut, double frequency, double sampleRate)
+{
+    double magnitude = 1.0;
+
+    if (!cut.template isBypassed<0>())
+        magnitude *= cut.template get<0>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
+    if (!cut.template isBypassed<1>())
+        magnitude *= cut.template get<1>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
+    if (!cut.template isBypassed<2>())
+        magnitude *= cut.template get<2>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
+    if (!cut.template isBypassed<3>())
+        magnitude *= cut.template get<3>().coefficients->getMagnitudeForFrequency(frequency, sampleRate);
+
+    return magnitude;
+}
+
+void AnalysisEngine::computeResponse(std::vector<float> &response, double sampleRate) const
+{
+    auto &lowcut = responseChain.get<ChainPositions::LowCut>();
+    auto &peak = responseChain.get<ChainPositions::Peak>();
+    auto &highcut = responseChain.get<ChainPositions::HighCut>();
+
+    response.resize(AnalysisSnapshot::numResponsePoints);
+
+    for (int i = 0; i < AnalysisSnapshot::numResponsePoints; i++)
+    {
+        double mag = 1.0;
+        auto freq = AnalysisSnapshot::getResponseFrequency(i);
+
+        if (!responseChain.isBypassed<ChainPositions::Peak>())
+            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
+
+        if (!responseChain.isBypassed<ChainPositions::LowCut>())
+            mag *= getCutMagnitudeForFrequency(lowcut, freq, sampleRate);
+
+        if (!responseChain.isBypassed<ChainPositions::HighCut>())
+            mag *= getCutMagnitudeForFrequency(highcut, freq, sampleRate);
+
+        response[(size_t)i] = (float)juce::Decibels::gainToDecibels(mag);
+    }
+}
+
+size_t AnalysisEngine::getMemoryUsage() const
+{
+    auto bytes = sizeof(*this);
+
+    bytes += (size_t)(monoBuffer.getNumSamples() + incomingBuffer.getNumSamples()) * sizeof(float);
+    bytes += leftChannelFFTDataGenerator.getMemoryUsage();
+    bytes += getCoefficientsMemoryUsage(responseChain);
+
+    if (auto snapshot = getLatestSnapshot())
+        bytes += sizeof(*snapshot) + (snapshot->spectrum.capacity() + snapshot->response.capacity()) * sizeof(float);
+
+    return bytes;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "PluginProcessor.h"
+#include "AnalyzerWorkerPool.h"
+#include "AnalyzerGovernor.h"
+#include "FrameTimings.h"
+#include "OctaveSmoother.h"
+#include "SharedMemoryPublisher.h"
+
+#include <memory>
+#include <vector>
+
+template <typename BlockType>
+struct FFTDataGenerator
+{
+    // Produces the FFT data from an audio buffer
+    void produceFFTDataForRendering(const juce::AudioBuffer<float> &audioData, const float negativeInfinity)
+    {
+        EQ_TRACE_SCOPE("produceFFTDataForRendering");
+
+        const auto fftSize = getFFTSize();
+
+        // Rendered straight into the frame the GUI will pick up next
+        auto &fftData = fftDataFrames.getWriteBuffer();
+        jassert((int)fftData.size() == fftSize * 2);
+
+        std::fill(fftData.begin(), fftData.end(), 0.0f);
+        auto *readIndex = audioData.getReadPointer(0);
+        std::copy(readIndex, readIndex + fftSize, fftData.begin());
+
+        // First apply a windowing function to our data
+        juce::FloatVectorOperations::multiply(fftData.data(), plan->window.data(), fftSize); // [1]
+
+        // Then render our FFT data
+        plan->fft.performFrequencyOnlyForwardTransform(fftData.data()); // [2]
+
+        int numBins = (int)fftSize / 2;
+
+        // Smoothing works on power, so it goes before the conversion to decibels
+        smoother.process(fftData.data());
+
+        // Normalize the fft values and convert them to decibels in one pass. Infinities and
+        // NaNs end up at 'negativeInfinity'.
+        Kernels::gainToDecibels(fftData.data(), numBins, 1.0f / float(numBins), negativeInfinity);
+
+        fftDataFrames.publish();
+    }
+
+    void changeOrder(FFTOrder newOrder)
+    {
+        // The FFT and window only depend on the order, so every generator in the process
+        // shares them; only the frames are per generator
+        plan = planCache->getPlan(newOrder);
+        auto fftSize = getFFTSize();
+
+        // The transform works in place, so each frame holds the whole workspace; only
+        // the first fftSize / 2 values are bins
+        fftDataFrames.prepare(BlockType((size_t)fftSize * 2, 0.0f));
+
+        smoother.prepare(fftSize / 2, smoother.getBandsPerOctave());
+    }
+
+    // 'bandsPerOctave' as for OctaveSmoother, 0 for none. Allocates when it changes.
+    void setSmoothing(int bandsPerOctave) { smoother.prepare(getFFTSize() / 2, bandsPerOctave); }
+    int getSmoothing() const { return smoother.getBandsPerOctave(); }
+    int getFFTSize() const { return plan != nullptr ? plan->getSize() : 0; }
+    FFTOrder getOrder() const { return plan != nullptr ? plan->order : FFTOrder::order2048; }
+
+    // Picks up the newest frame, if one has been produced since the last call
+    bool acquireFFTData() { return fftDataFrames.acquire(); }
+    const BlockType &getFFTData() { return fftDataFrames.getReadBuffer(); }
+
+    juce::uint64 getNumSkippedFrames() const { return fftDataFrames.getNumOverwritten(); }
+
+    // Not counting the plan, which is shared
+    size_t getMemoryUsage() const
+    {
+        return fftDataFrames.getMemoryUsage() + smoother.getMemoryUsage();
+    }
+
+private:
+    OctaveSmoother smoother;
+    juce::SharedResourcePointer<FFTPlanCache> planCache;
+    std::shared_ptr<const FFTPlan> plan;
+    LatestFrame<BlockType> fftDataFrames;
+};
+
+// Choices of the "Analyzer Smoothing" parameter, in bands per octave, 0 being none
+constexpr int analyzerSmoothingChoices[] = {0, 24, 12, 6, 3, 2, 1};
+
+// One frame of analysis. Snapshots are never modified once published, so any number of
+// readers can hold on to one for as long as they like.
+struct AnalysisSnapshot
+{
+    // The response curve is sampled at these many log-spaced points from 20 Hz to 20 kHz
+    static constexpr int numResponsePoints = 512;
+    static constexpr double minFrequency = 20.0;
+    static constexpr double maxFrequency = 20000.0;
+
+    static double getResponseFrequency(int index)
+    {
+        return juce::mapToLog10((double)index / (double)(numResponsePoints - 1), minFrequency, maxFrequency);
+    }
+
+    juce::uint64 frameIndex{0};
+
+    double sampleRate{0};
+    int fftSize{0};
+
+    // The AnalyzerGovernor level the frame was produced at
+    int qualityLevel{0};
+
+    // Left channel spectrum, fftSize / 2 bins in decibels, smoothed over
+    // 1 / smoothingBandsPerOctave of an octave unless that's 0
+    std::vector<float> spectrum;
+    int smoothingBandsPerOctave{0};
+    juce::uint64 spectrumIndex{0}; // Changes whenever 'spectrum' does
+
+    // Level of the analysed channel over the audio that arrived since the previous frame
+    float peakDecibels{-100.0f};
+    float rmsDecibels{-100.0f};
+
+    // Magnitude of the chain in decibels, at getResponseFrequency(i)
+    std::vector<float> response;
+    juce::uint64 responseIndex{0}; // Changes whenever 'response' does
+};
+
+// Spectrum and response analysis, owned by the processor so it runs whether or not an editor is
+// open. The process-wide AnalyzerWorkerPool produces a snapshot per frame, and any number of
+// editors (or tests, or batch tools) read the latest one without redoing the work.
+class AnalysisEngine : private AnalyzerWorkerPool::Client
+{
+public:
+    explicit AnalysisEngine(AudioPluginAudioProcessor &processor);
+    ~AnalysisEngine() override;
+
+    // Adds the engine to the worker pool and takes it out again. stop() waits for a frame in
+    // progress to finish. Call both from the same thread, usually the message thread.
+    void start();
+    void stop();
+
+    // Safe from any thread. Null until the first frame has been produced.
+    std::shared_ptr<const AnalysisSnapshot> getLatestSnapshot() const;
+
+    // Runs one frame on the calling thread. Used by the worker pool, or by anything that
+    // wants to drive the engine itself after calling stop().
+    void processNextFrame();
+
+    size_t getMemoryUsage() const;
+
+    // Decides how much work each frame does. Editors report their own frame times to it.
+    AnalyzerGovernor &getGovernor() { return governor; }
+
+    // Rolling timings of the analysis stages, and of the editors' drawing, which they add
+    // themselves. Kept here so they outlive any one editor.
+    FrameTimings &getFrameTimings() { return frameTimings; }
+
+    // The FFT plans every instance in the process shares
+    size_t getSharedPlanMemoryUsage() const { return planCache->getMemoryUsage(); }
+
+    // Publishes every frame into a POSIX shared-memory block for external monitoring.
+    // Off by default; the processor turns it on when EQUALIZER_SHARED_MONITOR is set.
+    // getSharedMemoryName() is empty while it's off or couldn't be set up.
+    bool setSharedMemoryExportEnabled(bool shouldBeEnabled);
+    bool isSharedMemoryExportEnabled() const;
+    juce::String getSharedMemoryName() const;
+
+private:
+    AudioPluginAudioProcessor &processorRef;
+
+    juce::SharedResourcePointer<AnalyzerWorkerPool> workerPool;
+    juce::SharedResourcePointer<FFTPlanCache> planCache;
+    bool isRunning = false;
+
+    juce::CriticalSection publisherLock;
+    SharedMemoryPublisher publisher;
+
+    // Only touched by whichever thread runs processNextFrame()
+    juce::AudioBuffer<float> monoBuffer;
+    juce::AudioBuffer<float> incomingBuffer; // Swapped with the analyzer FIFO's blocks
+    FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
+
+    AnalyzerGovernor governor;
+    FrameTimings frameTimings;
+
+    std::atomic<float> *smoothingParameter = nullptr;
+    double lastFrameMilliseconds = 0.0;
+    int framesUntilNextRun = 0;
+    int samplesSinceLastFFT = 0;
+
+    // Level of the audio that arrived since the last published frame
+    float pendingPeak = 0.0f;
+    double pendingSumOfSquares = 0.0;
+    int pendingNumSamples = 0;
+
+    MonoChain<float> responseChain;
+    ChainSettings lastChainSettings;
+    double lastSampleRate = 0.0;
+
+    std::shared_ptr<const AnalysisSnapshot> latestSnapshot;
+
+    void runAnalysisFrame() override { processNextFrame(); }
+
+    void changeOrder(FFTOrder newOrder);
+    void updateResponseChain(const ChainSettings &chainSettings, double sampleRate);
+    void computeResponse(std::vector<float> &response, double sampleRate) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisEngine)
+};
@@ -0,0 +1,100 @@
+#include "AnalyzerGovernor.h"
+
+namespace
+{
+// Full quality is what the analyzer always did: a 2048 point FFT on every frame that has new
+// audio, at 60 frames a second
+const AnalyzerQuality qualities[AnalyzerGovernor::numLevels] = {
+    {"Full", FFTOrder::order2048, 8, 1, 2},
+    {"Reduced", FFTOrder::order2048, 4, 2, 3},
+    {"Low", FFTOrder::order1024, 2, 3, 4},
+    {"Minimal", FFTOrder::order1024, 1, 6, 8},
+};
+
+// Audio
+constexpr double criticalAudioLoad = 0.85;
+constexpr double highAudioLoad = 0.6;
+constexpr double lowAudioLoad = 0.35;
+
+// Message thread, against a 16 ms frame that the rest of the host's GUI has to share
+constexpr double highMessageThreadMs = 8.0;
+constexpr double lowMessageThreadMs = 3.0;
+
+// The analysis frame, on the worker pool
+constexpr double highAnalysisMs = 4.0;
+constexpr double lowAnalysisMs = 1.5;
+
+// Editors report at their own rate, which may be slower than the pool's frames, so the worst
+// recent time fades out over a few frames rather than vanishing between reports
+constexpr double messageThreadDecayPerFrame = 0.9;
+} // namespace
+
+const AnalyzerQuality &AnalyzerGovernor::getQuality(int level)
+{
+    return qualities[juce::jlimit(0, numLevels - 1, level)];
+}
+
+void AnalyzerGovernor::reportMessageThreadTime(double milliseconds)
+{
+    auto worst = worstMessageThreadMs.load(std::memory_order_relaxed);
+
+    while (milliseconds > worst && !worstMessageThreadMs.compare_exchange_weak(worst, (float)milliseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+int AnalyzerGovernor::update(double audioLoad, int numAudioOverruns, double analysisMilliseconds, double nowMilliseconds)
+{
+    auto reported = (double)worstMessageThreadMs.exchange(0.0f, std::memory_order_relaxed);
+    recentMessageThreadMs = juce::jmax(reported, recentMessageThreadMs * messageThreadDecayPerFrame);
+
+    // The count starts again from zero when the processor is prepared
+    auto hasOverrun = numAudioOverruns > lastNumAudioOverruns;
+    lastNumAudioOverruns = numAudioOverruns;
+
+    auto current = getLevel();
+    auto next = current;
+
+    if (hasOverrun || audioLoad > criticalAudioLoad)
+    {
+        next = numLevels - 1;
+        pressureSinceMs = idleSinceMs = -1.0;
+    }
+    else if (audioLoad > highAudioLoad || recentMessageThreadMs > highMessageThreadMs || analysisMilliseconds > highAnalysisMs)
+    {
+        idleSinceMs = -1.0;
+
+        if (pressureSinceMs < 0.0)
+            pressureSinceMs = nowMilliseconds;
+
+        // One step at a time, each after its own spell of pressure
+        if (nowMilliseconds - pressureSinceMs >= stepDownAfterMs)
+        {
+            next = juce::jmin(current + 1, numLevels - 1);
+            pressureSinceMs = nowMilliseconds;
+        }
+    }
+    else if (audioLoad < lowAudioLoad && recentMessageThreadMs < lowMessageThreadMs && analysisMilliseconds < lowAnalysisMs)
+    {
+        pressureSinceMs = -1.0;
+
+        if (idleSinceMs < 0.0)
+            idleSinceMs = nowMilliseconds;
+
+        if (nowMilliseconds - idleSinceMs >= stepUpAfterMs)
+        {
+            next = juce::jmax(current - 1, 0);
+            idleSinceMs = nowMilliseconds;
+        }
+    }
+    else
+    {
+        // In between: stay put
+        pressureSinceMs = idleSinceMs = -1.0;
+    }
+
+    if (next != current)
+        level.store(next, std::memory_order_relaxed);
+
+    return next;
+}
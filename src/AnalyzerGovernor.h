@@ -0,0 +1,60 @@
+#pragma once
+
+#include "AnalyzerWorkerPool.h"
+
+#include <atomic>
+
+// How much work the analyzer does per second at one quality level
+struct AnalyzerQuality
+{
+    const char *name;
+    FFTOrder order;
+    int overlap;        // A new FFT every fftSize / overlap samples of incoming audio, at most once a frame
+    int frameDivisor;   // Runs on every n-th frame of the worker pool, and the editor redraws as often
+    int pathResolution; // Pixels between the points of the analyzer path
+};
+
+// Steps the analyzer's quality down when the machine is busy and back up once it's idle again.
+// It watches three things: the audio callback's load, the time editors spend on the message
+// thread per frame, and the analysis frame itself. Audio wins outright: an overrun or a nearly
+// full callback drops straight to the lowest level, and it takes a long quiet spell to come back.
+//
+// update() is called by the analysis engine once per worker pool frame; everything else is
+// safe from any thread.
+class AnalyzerGovernor
+{
+public:
+    static constexpr int numLevels = 4;
+
+    AnalyzerGovernor() = default;
+
+    // Level 0 is full quality
+    static const AnalyzerQuality &getQuality(int level);
+
+    int getLevel() const { return level.load(std::memory_order_relaxed); }
+    const AnalyzerQuality &getQuality() const { return getQuality(getLevel()); }
+
+    // Time an editor spent on the analyzer display for a frame (timer callback and paint)
+    void reportMessageThreadTime(double milliseconds);
+
+    // 'audioLoad' is the callback's time over the block's duration, 'numAudioOverruns' a running
+    // count of callbacks that took longer than their block, as juce::AudioProcessLoadMeasurer
+    // gives them. Returns the level to use for this frame.
+    int update(double audioLoad, int numAudioOverruns, double analysisMilliseconds, double nowMilliseconds);
+
+private:
+    // Step down once under pressure for this long, up once idle for this long
+    static constexpr double stepDownAfterMs = 250.0;
+    static constexpr double stepUpAfterMs = 3000.0;
+
+    std::atomic<int> level{0};
+    std::atomic<float> worstMessageThreadMs{0.0f};
+
+    // Only touched by update()
+    double recentMessageThreadMs = 0.0;
+    double pressureSinceMs = -1.0;
+    double idleSinceMs = -1.0;
+    int lastNumAudioOverruns = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(AnalyzerGovernor)
+};
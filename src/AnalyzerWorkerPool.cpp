@@ -0,0 +1,185 @@
+#include "AnalyzerWorkerPool.h"
+
+#include <algorithm>
+
+FFTPlan::FFTPlan(FFTOrder fftOrder) : order(fftOrder),
+                                      fft(fftOrder),
+                                      window((size_t)getSize())
+{
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), window.size(),
+                                                             juce::dsp::WindowingFunction<float>::blackmanHarris);
+}
+
+size_t FFTPlan::getMemoryUsage() const
+{
+    // The FFT keeps its own twiddle tables, roughly one complex value per point
+    auto size = (size_t)getSize();
+    return sizeof(*this) + window.capacity() * sizeof(float) + size * sizeof(std::complex<float>);
+}
+
+std::shared_ptr<const FFTPlan> FFTPlanCache::getPlan(FFTOrder order)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto &plan = plans[order];
+
+    if (plan == nullptr)
+        plan = std::make_shared<const FFTPlan>(order);
+
+    return plan;
+}
+
+size_t FFTPlanCache::getMemoryUsage() const
+{
+    const juce::ScopedLock sl(lock);
+
+    size_t bytes = 0;
+
+    for (const auto &plan : plans)
+        bytes += plan.second->getMemoryUsage();
+
+    return bytes;
+}
+
+AnalyzerWorkerPool::Worker::Worker(AnalyzerWorkerPool &pool, int index) : juce::Thread("Analyzer worker " + juce::String(index + 1)),
+                                                                          owner(pool)
+{
+}
+
+void AnalyzerWorkerPool::Worker::run()
+{
+    while (!threadShouldExit())
+    {
+        int waitMs = 0;
+
+        if (auto *client = owner.takeNextClient(waitMs))
+        {
+            client->runAnalysisFrame();
+            owner.finishClient(*client);
+        }
+        else
+        {
+            wait(waitMs);
+        }
+    }
+}
+
+// Analysis is a handful of FFTs per frame, so a couple of threads go a long way, and leaving
+// the other cores alone matters more to the audio threads than shaving a frame of latency
+AnalyzerWorkerPool::AnalyzerWorkerPool()
+{
+    auto numThreads = juce::jlimit(1, maxNumThreads, juce::SystemStats::getNumCpus() - 1);
+
+    for (int i = 0; i < numThreads; i++)
+    {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+        workers.back()->startThread(juce::Thread::Priority::low);
+    }
+}
+
+AnalyzerWorkerPool::~AnalyzerWorkerPool()
+{
+    // Every client should have removed itself by now
+    jassert(clients.empty());
+
+    for (auto &worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (auto &worker : workers)
+        worker->stopThread(1000);
+}
+
+void AnalyzerWorkerPool::addClient(Client &client)
+{
+    const juce::ScopedLock sl(lock);
+
+    jassert(std::find(clients.begin(), clients.end(), &client) == clients.end());
+    clients.push_back(&client);
+
+    // Room for every client, so refilling the queue each frame doesn't allocate
+    frameQueue.reserve(clients.size());
+    running.reserve(clients.size());
+}
+
+void AnalyzerWorkerPool::removeClient(Client &client)
+{
+    auto erase = [&client](std::vector<Client *> &list)
+    {
+        list.erase(std::remove(list.begin(), list.end(), &client), list.end());
+    };
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        erase(clients);
+
+        // Entries before 'nextInQueue' have already been taken
+        auto position = std::find(frameQueue.begin() + (std::ptrdiff_t)nextInQueue, frameQueue.end(), &client);
+
+        if (position != frameQueue.end())
+            frameQueue.erase(position);
+    }
+
+    for (;;)
+    {
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (std::find(running.begin(), running.end(), &client) == running.end())
+                return;
+        }
+
+        clientFinished.wait(5);
+    }
+}
+
+AnalyzerWorkerPool::Client *AnalyzerWorkerPool::takeNextClient(int &waitMs)
+{
+    const juce::ScopedLock sl(lock);
+
+    const auto frameIntervalMs = 1000.0 / framesPerSecond;
+
+    if (nextInQueue == frameQueue.size())
+    {
+        auto now = juce::Time::getMillisecondCounterHiRes();
+
+        if (now < nextFrameTimeMs)
+        {
+            waitMs = juce::jmax(1, (int)(nextFrameTimeMs - now));
+            return nullptr;
+        }
+
+        // Start the next frame. If the last one overran, don't try to catch up.
+        nextFrameTimeMs = juce::jmax(nextFrameTimeMs + frameIntervalMs, now);
+
+        frameQueue.clear();
+        nextInQueue = 0;
+
+        for (auto *client : clients)
+        {
+            if (std::find(running.begin(), running.end(), client) == running.end())
+                frameQueue.push_back(client);
+        }
+    }
+
+    if (nextInQueue == frameQueue.size())
+    {
+        waitMs = juce::jmax(1, (int)frameIntervalMs);
+        return nullptr;
+    }
+
+    auto *client = frameQueue[nextInQueue++];
+    running.push_back(client);
+
+    return client;
+}
+
+void AnalyzerWorkerPool::finishClient(Client &client)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        running.erase(std::find(running.begin(), running.end(), &client));
+    }
+
+    clientFinished.signal();
+}
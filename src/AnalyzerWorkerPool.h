@@ -0,0 +1,105 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+enum FFTOrder
+{
+    order1024 = 10,
+    order2048 = 11,
+    order4096 = 12,
+    order8192 = 13
+};
+
+// Everything an FFT of one order needs that doesn't change between frames. Plans are
+// immutable once built, so any number of threads can use one at the same time.
+struct FFTPlan
+{
+    explicit FFTPlan(FFTOrder fftOrder);
+
+    int getSize() const { return 1 << order; }
+    size_t getMemoryUsage() const;
+
+    const FFTOrder order;
+    const juce::dsp::FFT fft;
+    std::vector<float> window; // Normalised Blackman-Harris, getSize() points
+};
+
+// Process-wide cache of FFT plans, one per order. Share it through
+// juce::SharedResourcePointer<FFTPlanCache>. Plans stay cached for as long as the cache lives.
+class FFTPlanCache
+{
+public:
+    // Builds the plan the first time an order is asked for. Call off the audio thread.
+    std::shared_ptr<const FFTPlan> getPlan(FFTOrder order);
+
+    size_t getMemoryUsage() const;
+
+private:
+    juce::CriticalSection lock;
+    std::map<FFTOrder, std::shared_ptr<const FFTPlan>> plans;
+};
+
+// Process-wide set of low priority threads that run every instance's analysis, so the work
+// doesn't grow a thread per instance or land on the message thread. Share it through
+// juce::SharedResourcePointer<AnalyzerWorkerPool>.
+//
+// Clients are run once per frame, in the order they were added. A client is never run on two
+// threads at once; if its previous frame is still going when the next one starts, it skips it.
+class AnalyzerWorkerPool
+{
+public:
+    static constexpr int framesPerSecond = 60;
+    static constexpr int maxNumThreads = 2;
+
+    struct Client
+    {
+        virtual ~Client() = default;
+
+        // Called on one of the pool's threads, once per frame
+        virtual void runAnalysisFrame() = 0;
+    };
+
+    AnalyzerWorkerPool();
+    ~AnalyzerWorkerPool();
+
+    // The client is run from the next frame on
+    void addClient(Client &client);
+
+    // Blocks until any frame the client is in the middle of has finished, so after this
+    // returns it's safe to destroy it. Don't call it from the client's own runAnalysisFrame().
+    void removeClient(Client &client);
+
+    int getNumThreads() const { return (int)workers.size(); }
+
+private:
+    struct Worker : juce::Thread
+    {
+        Worker(AnalyzerWorkerPool &pool, int index);
+
+        void run() override;
+
+        AnalyzerWorkerPool &owner;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // Everything below is guarded by 'lock'
+    juce::CriticalSection lock;
+    std::vector<Client *> clients;
+    std::vector<Client *> frameQueue; // Clients still to run this frame
+    std::vector<Client *> running;
+    size_t nextInQueue = 0;
+    double nextFrameTimeMs = 0.0;
+
+    juce::WaitableEvent clientFinished;
+
+    // Returns the next client to run, or null with 'waitMs' set to how long until there's work
+    Client *takeNextClient(int &waitMs);
+    void finishClient(Client &client);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyzerWorkerPool)
+};
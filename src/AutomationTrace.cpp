@@ -0,0 +1,227 @@
+#include "AutomationTrace.h"
+
+namespace AutomationTrace
+{
+Recorder::Recorder(juce::AudioProcessorValueTreeState &apvts, const juce::StringArray &parameterIDs) : ids(parameterIDs)
+{
+    jassert(ids.size() <= maxParameters);
+
+    for (const auto &id : ids)
+    {
+        parameters.push_back(apvts.getRawParameterValue(id));
+        jassert(parameters.back() != nullptr);
+    }
+}
+
+Recorder::~Recorder()
+{
+    stop();
+}
+
+bool Recorder::start(const juce::File &traceFile)
+{
+    stop();
+
+    auto newStream = std::make_unique<juce::FileOutputStream>(traceFile);
+
+    if (!newStream->openedOk())
+        return false;
+
+    newStream->setPosition(0);
+    newStream->truncate();
+
+    newStream->writeInt((int)magic);
+    newStream->writeInt((int)version);
+    newStream->writeCompressedInt(ids.size());
+
+    for (const auto &id : ids)
+        newStream->writeString(id);
+
+    {
+        const juce::SpinLock::ScopedLockType sl(lock);
+
+        events.prepare(queueSize, Event{});
+        stream = std::move(newStream);
+        file = traceFile;
+
+        writeEvent(lastPrepare);
+        recording.store(true);
+    }
+
+    workerPool->addClient(*this);
+    return true;
+}
+
+void Recorder::stop()
+{
+    if (!recording.load())
+        return;
+
+    {
+        const juce::SpinLock::ScopedLockType sl(lock);
+        recording.store(false);
+    }
+
+    // Once the pool is done with us, whatever is left in the queue is ours to write
+    workerPool->removeClient(*this);
+    writePendingEvents();
+
+    stream->flush();
+    stream.reset();
+}
+
+void Recorder::recordPrepare(double sampleRate, int maximumBlockSize, int numChannels, bool doublePrecision)
+{
+    const juce::SpinLock::ScopedLockType sl(lock);
+
+    lastPrepare.type = Event::prepare;
+    lastPrepare.sampleRate = sampleRate;
+    lastPrepare.maximumBlockSize = maximumBlockSize;
+    lastPrepare.numChannels = numChannels;
+    lastPrepare.doublePrecision = doublePrecision;
+
+    if (recording.load())
+    {
+        auto event = lastPrepare;
+        events.push(event);
+    }
+}
+
+void Recorder::recordBlock(int numSamples)
+{
+    const juce::SpinLock::ScopedTryLockType sl(lock);
+
+    // Only fails while start() or stop() is changing things over
+    if (!sl.isLocked() || !recording.load(std::memory_order_relaxed))
+        return;
+
+    Event event;
+    event.type = Event::block;
+    event.numSamples = numSamples;
+
+    for (size_t i = 0; i < parameters.size(); i++)
+        event.values[i] = parameters[i] != nullptr ? parameters[i]->load(std::memory_order_relaxed) : 0.0f;
+
+    events.push(event);
+}
+
+void Recorder::runAnalysisFrame()
+{
+    writePendingEvents();
+
+    // So a trace survives the host going down, which is often when it's wanted most
+    stream->flush();
+}
+
+void Recorder::writePendingEvents()
+{
+    Event event;
+
+    while (events.getNumAvailableForReading() > 0 && events.pull(event))
+        writeEvent(event);
+}
+
+void Recorder::writeEvent(const Event &event)
+{
+    if (event.type == Event::prepare)
+    {
+        stream->writeCompressedInt(0);
+        stream->writeDouble(event.sampleRate);
+        stream->writeCompressedInt(event.maximumBlockSize);
+        stream->writeCompressedInt(event.numChannels);
+        stream->writeCompressedInt(event.doublePrecision ? 1 : 0);
+
+        valuesWritten = false;
+        return;
+    }
+
+    int changed = 0;
+
+    for (int i = 0; i < ids.size(); i++)
+    {
+        if (!valuesWritten || event.values[(size_t)i] != lastValues[(size_t)i])
+            changed |= 1 << i;
+    }
+
+    stream->writeCompressedInt(event.numSamples);
+    stream->writeCompressedInt(changed);
+
+    for (int i = 0; i < ids.size(); i++)
+    {
+        if ((changed & (1 << i)) != 0)
+            stream->writeFloat(event.values[(size_t)i]);
+    }
+
+    lastValues = event.values;
+    valuesWritten = true;
+}
+
+bool Reader::open(const juce::File &file)
+{
+    stream = std::make_unique<juce::FileInputStream>(file);
+    ids.clear();
+    values.fill(0.0f);
+
+    if (!stream->openedOk() || (juce::uint32)stream->readInt() != magic || (juce::uint32)stream->readInt() != version)
+    {
+        stream.reset();
+        return false;
+    }
+
+    auto numParameters = stream->readCompressedInt();
+
+    if (numParameters < 0 || numParameters > maxParameters)
+    {
+        stream.reset();
+        return false;
+    }
+
+    for (int i = 0; i < numParameters; i++)
+        ids.add(stream->readString());
+
+    return true;
+}
+
+bool Reader::readNext(Event &event)
+{
+    if (stream == nullptr || stream->getNumBytesRemaining() <= 0)
+        return false;
+
+    auto numSamples = stream->readCompressedInt();
+
+    if (numSamples < 0)
+        return false;
+
+    // A host that went down mid-write can leave the last record short
+    if (numSamples == 0)
+    {
+        if (stream->getNumBytesRemaining() < (juce::int64)sizeof(double) + 3)
+            return false;
+
+        event.type = Event::prepare;
+        event.sampleRate = stream->readDouble();
+        event.maximumBlockSize = stream->readCompressedInt();
+        event.numChannels = stream->readCompressedInt();
+        event.doublePrecision = stream->readCompressedInt() != 0;
+    }
+    else
+    {
+        auto changed = stream->readCompressedInt();
+
+        if (stream->getNumBytesRemaining() < (juce::int64)sizeof(float) * juce::countNumberOfBits((juce::uint32)changed))
+            return false;
+
+        for (int i = 0; i < ids.size(); i++)
+        {
+            if ((changed & (1 << i)) != 0)
+                values[(size_t)i] = stream->readFloat();
+        }
+
+        event.type = Event::block;
+        event.numSamples = numSamples;
+        event.values = values;
+    }
+
+    return true;
+}
+} // namespace AutomationTrace
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include "AnalyzerWorkerPool.h"
+#include "FrameChannel.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+// Recording of what the processor was asked to do, block by block: the value of each chain
+// parameter and the size of every block, plus the sample rate and layout from each
+// prepareToPlay. tools/TraceReplay.cpp feeds a trace back through processBlock and times it,
+// so automation from a real session can be reproduced and benchmarked.
+//
+// File layout, little-endian, with "int" meaning juce::OutputStream::writeCompressedInt():
+//
+//     magic and version (32 bits each), number of parameters (int), then each parameter ID as
+//     a null-terminated UTF-8 string
+//
+//     a run of records, each starting with an int:
+//         0      prepare: sample rate (double), maximum block size, number of channels and
+//                1 for double precision or 0 for float (ints)
+//         n > 0  a block of n samples: a mask of the parameters that changed since the
+//                previous block (int), then each changed value (float), in parameter order
+//
+// The first block after a prepare record has every bit of its mask set. A block with no
+// automation costs two or three bytes.
+namespace AutomationTrace
+{
+constexpr juce::uint32 magic = 0x54415145; // "EQAT"
+constexpr juce::uint32 version = 1;
+
+// The changed mask is a non-negative int
+constexpr int maxParameters = 31;
+
+struct Event
+{
+    enum Type
+    {
+        prepare,
+        block
+    };
+
+    Type type{prepare};
+
+    // prepare
+    double sampleRate{0};
+    int maximumBlockSize{0};
+    int numChannels{0};
+    bool doublePrecision{false};
+
+    // block, with every parameter's value as of that block, not just the changes
+    int numSamples{0};
+    std::array<float, maxParameters> values{};
+};
+
+// Owned by the processor. recordBlock() is called from processBlock and only copies the
+// values into a queue; the analyzer worker pool does the encoding and file writes.
+class Recorder : private AnalyzerWorkerPool::Client
+{
+public:
+    Recorder(juce::AudioProcessorValueTreeState &apvts, const juce::StringArray &parameterIDs);
+    ~Recorder() override;
+
+    // Starts a new trace in 'file', replacing it if it exists. The trace opens with the
+    // settings of the last recordPrepare(). Call start() and stop() from the message thread.
+    bool start(const juce::File &file);
+    void stop();
+
+    bool isRecording() const { return recording.load(); }
+    juce::File getFile() const { return file; }
+
+    // Blocks that didn't fit in the queue since start(). Their values are still caught by
+    // the next block that does, but their timing is lost.
+    juce::uint64 getNumDroppedBlocks() const { return events.getNumOverflows(); }
+
+    // The queue, which is only full size while recording
+    size_t getMemoryUsage() const { return events.getMemoryUsage(); }
+
+    // Call from prepareToPlay, whether recording or not
+    void recordPrepare(double sampleRate, int maximumBlockSize, int numChannels, bool doublePrecision);
+
+    // Call from processBlock. Doesn't allocate, lock or wait; does nothing unless recording.
+    void recordBlock(int numSamples);
+
+private:
+    juce::StringArray ids;
+    std::vector<std::atomic<float> *> parameters;
+
+    juce::File file;
+    std::unique_ptr<juce::FileOutputStream> stream;
+
+    // About a second of 32-sample blocks at 96 kHz, drained at the pool's frame rate
+    static constexpr int queueSize = 4096;
+
+    FrameChannel<Event> events;
+    Event lastPrepare;
+
+    // Taken by start() and stop() around changing the queue. The audio thread only tries it.
+    juce::SpinLock lock;
+    std::atomic<bool> recording{false};
+
+    // Used by whichever side is writing the file, the pool while recording, stop() after
+    std::array<float, maxParameters> lastValues{};
+    bool valuesWritten = false;
+
+    juce::SharedResourcePointer<AnalyzerWorkerPool> workerPool;
+
+    void runAnalysisFrame() override;
+    void writeEvent(const Event &event);
+    void writePendingEvents();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Recorder)
+};
+
+class Reader
+{
+public:
+    // Returns false if the file can't be read or isn't a trace
+    bool open(const juce::File &file);
+
+    const juce::StringArray &getParameterIDs() const { return ids; }
+
+    // The next record, or false at the end of the file or if it's cut short
+    bool readNext(Event &event);
+
+private:
+    std::unique_ptr<juce::FileInputStream> stream;
+    juce::StringArray ids;
+    std::array<float, maxParameters> values{};
+};
+} // namespace AutomationTrace
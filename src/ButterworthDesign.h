@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// Analytic Butterworth design for the cut filters. The cut orders are fixed at 2, 4, 6 and 8
+// (one to four biquads), so the pole angles are tabulated and a design costs a single tan(),
+// written straight into storage the caller already owns.
+namespace Butterworth
+{
+constexpr int maxSections = 4;
+
+// Damping of each section, 2 cos(theta_k) = 1 / Q_k, where theta_k = (2k + 1) pi / 2n is the
+// angle of the k-th pole pair from the negative real axis. Row i is order 2 * (i + 1).
+constexpr std::array<std::array<double, maxSections>, maxSections> damping{{
+    {{1.4142135623730951, 0.0, 0.0, 0.0}},
+    {{1.8477590650225735, 0.76536686473017967, 0.0, 0.0}},
+    {{1.9318516525781366, 1.4142135623730951, 0.51763809020504148, 0.0}},
+    {{1.9615705608064609, 1.6629392246050905, 1.1111404660392046, 0.39018064403225666}},
+}};
+
+constexpr double getDamping(int order, int section)
+{
+    return damping[(size_t)(order / 2 - 1)][(size_t)section];
+}
+
+// Highest cutoff any design uses, as a fraction of the sample rate. tan() blows up at Nyquist
+// and wraps negative past it, so a 20 kHz cut at 44.1 kHz or below would come out broken.
+constexpr double maxFrequencyRatio = 0.499;
+
+inline double clampFrequency(double frequency, double sampleRate)
+{
+    return std::min(frequency, maxFrequencyRatio * sampleRate);
+}
+
+// Pre-warped bilinear transform of the cutoff, shared by every section of a cascade
+inline double getK(double frequency, double sampleRate)
+{
+    return std::tan(3.14159265358979323846 * clampFrequency(frequency, sampleRate) / sampleRate);
+}
+
+// Writes one section normalised as b0, b1, b2, a1, a2, the layout of IIR::Coefficients
+template <typename SampleType>
+void designSection(SampleType *coefficients, double K, double sectionDamping, bool isHighPass)
+{
+    auto K2 = K * K;
+    auto norm = 1.0 / (1.0 + sectionDamping * K + K2);
+
+    auto b0 = isHighPass ? norm : K2 * norm;
+    auto b1 = isHighPass ? -2.0 * b0 : 2.0 * b0;
+
+    coefficients[0] = (SampleType)b0;
+    coefficients[1] = (SampleType)b1;
+    coefficients[2] = (SampleType)b0;
+    coefficients[3] = (SampleType)(2.0 * (K2 - 1.0) * norm);
+    coefficients[4] = (SampleType)((1.0 - sectionDamping * K + K2) * norm);
+}
+
+// Designs all order / 2 sections of a cut, sections[i] pointing at each section's storage
+template <typename SampleType>
+void designCut(SampleType *const *sections, int order, double frequency, double sampleRate, bool isHighPass)
+{
+    auto K = getK(frequency, sampleRate);
+
+    for (int s = 0; s < order / 2; s++)
+    {
+        designSection(sections[s], K, getDamping(order, s), isHighPass);
+    }
+}
+} // namespace Butterworth
@@ -0,0 +1,70 @@
+#include "ChannelThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+// The calling thread does its share of the work too, so leave it a core
+ChannelThreadPool::ChannelThreadPool() : numThreads(juce::jmax(1, juce::SystemStats::getNumCpus() - 1)),
+                                         pool(numThreads)
+{
+}
+
+ChannelThreadPool::~ChannelThreadPool()
+{
+    pool.removeAllJobs(true, 5000);
+}
+
+namespace
+{
+// Shared by the caller and its jobs. The pool is shared between instances too, so a job can
+// sit in the queue behind other instances' work until after its caller has returned; it then
+// still has valid state to look at, finds every index taken and exits.
+struct ParallelFor
+{
+    ParallelFor(int numItemsToProcess, const std::function<void(int)> &functionToCall)
+        : numItems(numItemsToProcess), function(functionToCall)
+    {
+    }
+
+    const int numItems;
+
+    // Only called for an index that was handed out, which the caller waits for
+    const std::function<void(int)> &function;
+
+    std::atomic<int> nextIndex{0};
+    std::atomic<int> numCompleted{0};
+    juce::WaitableEvent finished;
+
+    void work()
+    {
+        for (auto index = nextIndex++; index < numItems; index = nextIndex++)
+        {
+            function(index);
+
+            if (++numCompleted == numItems)
+            {
+                finished.signal();
+            }
+        }
+    }
+};
+} // namespace
+
+void ChannelThreadPool::parallelFor(int numItems, const std::function<void(int)> &function)
+{
+    if (numItems <= 0)
+        return;
+
+    auto state = std::make_shared<ParallelFor>(numItems, function);
+    auto numJobs = juce::jmin(numThreads, numItems - 1);
+
+    for (int i = 0; i < numJobs; i++)
+    {
+        pool.addJob([state]
+                    { state->work(); });
+    }
+
+    // Done when every index has been processed, not when every job has run
+    state->work();
+    state->finished.wait();
+}
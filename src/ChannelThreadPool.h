@@ -0,0 +1,29 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <functional>
+
+// Process-wide pool used to spread channels over all cores while rendering offline.
+// Share it through juce::SharedResourcePointer<ChannelThreadPool>, so every instance
+// in the process uses the same threads.
+class ChannelThreadPool
+{
+public:
+    ChannelThreadPool();
+    ~ChannelThreadPool();
+
+    int getNumThreads() const { return numThreads; }
+
+    // Calls 'function(index)' once for every index in [0, numItems). Workers and the calling
+    // thread pull the next index from a shared counter, so a slow channel doesn't hold up the
+    // others. Returns once every index has been processed, without waiting for jobs that are
+    // still queued behind other instances' work; those find nothing left to do.
+    void parallelFor(int numItems, const std::function<void(int)> &function);
+
+private:
+    int numThreads;
+    juce::ThreadPool pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelThreadPool)
+};
@@ -0,0 +1,211 @@
+#include "CoefficientBank.h"
+
+#include "ButterworthDesign.h"
+#include "PeakDesign.h"
+
+#include <algorithm>
+
+template <typename SampleType>
+int CoefficientBank<SampleType>::getNumFrequencies()
+{
+    return (int)std::round((maxFrequency - minFrequency) / frequencyStep) + 1;
+}
+
+template <typename SampleType>
+size_t CoefficientBank<SampleType>::getExpectedMemoryUsage()
+{
+    auto numFrequencies = (size_t)getNumFrequencies();
+    auto numGains = (size_t)std::round((maxGainInDecibels - minGainInDecibels) / gainStepInDecibels) + 1;
+
+    return sizeof(CoefficientBank) +
+           2 * numFrequencies * numSectionsPerCutoff * numCoefficientsPerSection * sizeof(SampleType) +
+           (numFrequencies + numGains) * sizeof(double);
+}
+
+template <typename SampleType>
+CoefficientBank<SampleType>::CoefficientBank(double sampleRateToUse) : sampleRate(sampleRateToUse)
+{
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
+    auto numFrequencies = getNumFrequencies();
+    auto cutoffSize = (size_t)(numSectionsPerCutoff * numCoefficientsPerSection);
+
+    highPassSections.resize((size_t)numFrequencies * cutoffSize);
+    lowPassSections.resize((size_t)numFrequencies * cutoffSize);
+    peakK.resize((size_t)numFrequencies);
+
+    for (int i = 0; i < numFrequencies; i++)
+    {
+        // getK() clamps cutoffs below Nyquist, the same as for the direct designs
+        auto K = Butterworth::getK((double)(minFrequency + i * frequencyStep), sampleRate);
+
+        auto *highPass = highPassSections.data() + (size_t)i * cutoffSize;
+        auto *lowPass = lowPassSections.data() + (size_t)i * cutoffSize;
+
+        for (int order = 2; order <= 2 * Butterworth::maxSections; order += 2)
+        {
+            for (int s = 0; s < order / 2; s++)
+            {
+                Butterworth::designSection(highPass, K, Butterworth::getDamping(order, s), true);
+                Butterworth::designSection(lowPass, K, Butterworth::getDamping(order, s), false);
+
+                highPass += numCoefficientsPerSection;
+                lowPass += numCoefficientsPerSection;
+            }
+        }
+
+        peakK[(size_t)i] = K;
+    }
+
+    auto numGains = (int)std::round((maxGainInDecibels - minGainInDecibels) / gainStepInDecibels) + 1;
+    peakA.resize((size_t)numGains);
+
+    for (int i = 0; i < numGains; i++)
+    {
+        peakA[(size_t)i] = PeakEQ::getA(minGainInDecibels + i * gainStepInDecibels);
+    }
+
+    buildTimeSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+}
+
+template <typename SampleType>
+const SampleType *CoefficientBank<SampleType>::getCutSections(float frequency, int order, bool isHighPass) const
+{
+    auto position = (frequency - minFrequency) / frequencyStep;
+    auto index = (int)std::round(position);
+
+    if (index < 0 || index >= getNumFrequencies() || std::abs(position - (float)index) > 1.0e-3f)
+    {
+        return nullptr;
+    }
+
+    // Orders 2, 4, 6, 8 start at sections 0, 1, 3, 6
+    auto numSections = order / 2;
+    auto firstSection = (numSections - 1) * numSections / 2;
+
+    const auto &sections = isHighPass ? highPassSections : lowPassSections;
+
+    return sections.data() + ((size_t)index * numSectionsPerCutoff + (size_t)firstSection) * numCoefficientsPerSection;
+}
+
+template <typename SampleType>
+double CoefficientBank<SampleType>::interpolate(const std::vector<double> &table, float value, float minValue, float step)
+{
+    auto position = juce::jlimit(0.0, (double)table.size() - 1.0, (double)(value - minValue) / step);
+
+    // A value on the grid, which parameters with the same step always are, comes straight from
+    // the table; (value - minValue) / step rarely lands exactly on it, and the interpolation
+    // would leave it a little off the direct design
+    auto nearest = std::round(position);
+
+    if (std::abs(position - nearest) < 1.0e-3)
+    {
+        return table[(size_t)nearest];
+    }
+
+    auto index = juce::jmin((size_t)position, table.size() - 2);
+    auto fraction = position - (double)index;
+
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
+
+template <typename SampleType>
+double CoefficientBank<SampleType>::getPeakK(float frequency) const
+{
+    return interpolate(peakK, frequency, minFrequency, frequencyStep);
+}
+
+template <typename SampleType>
+double CoefficientBank<SampleType>::getPeakA(float gainInDecibels) const
+{
+    return interpolate(peakA, gainInDecibels, minGainInDecibels, gainStepInDecibels);
+}
+
+template <typename SampleType>
+size_t CoefficientBank<SampleType>::getMemoryUsage() const
+{
+    return sizeof(*this) +
+           (highPassSections.capacity() + lowPassSections.capacity()) * sizeof(SampleType) +
+           (peakK.capacity() + peakA.capacity()) * sizeof(double);
+}
+
+template class CoefficientBank<float>;
+template class CoefficientBank<double>;
+
+template <typename BankType>
+static size_t getBanksMemoryUsage(const std::vector<std::shared_ptr<const BankType>> &banks)
+{
+    size_t bytes = 0;
+
+    for (const auto &bank : banks)
+    {
+        bytes += bank->getMemoryUsage();
+    }
+
+    return bytes;
+}
+
+template <typename BankType>
+static void removeUnusedBanks(std::vector<std::shared_ptr<const BankType>> &banks)
+{
+    banks.erase(std::remove_if(banks.begin(), banks.end(), [](const auto &bank)
+                               { return bank.use_count() == 1; }),
+                banks.end());
+}
+
+size_t CoefficientBankCache::getMemoryUsageLocked() const
+{
+    return getBanksMemoryUsage(floatBanks) + getBanksMemoryUsage(doubleBanks);
+}
+
+size_t CoefficientBankCache::getMemoryUsage() const
+{
+    const juce::ScopedLock sl(lock);
+    return getMemoryUsageLocked();
+}
+
+void CoefficientBankCache::removeUnusedBanksLocked()
+{
+    removeUnusedBanks(floatBanks);
+    removeUnusedBanks(doubleBanks);
+}
+
+template <typename SampleType>
+std::shared_ptr<const CoefficientBank<SampleType>> CoefficientBankCache::getBank(double sampleRate)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto &banks = [this]() -> auto &
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleBanks;
+        else
+            return floatBanks;
+    }();
+
+    for (const auto &bank : banks)
+    {
+        if (bank->getSampleRate() == sampleRate)
+        {
+            return bank;
+        }
+    }
+
+    if (getMemoryUsageLocked() + CoefficientBank<SampleType>::getExpectedMemoryUsage() > maxMemoryBytes)
+    {
+        removeUnusedBanksLocked();
+
+        if (getMemoryUsageLocked() + CoefficientBank<SampleType>::getExpectedMemoryUsage() > maxMemoryBytes)
+        {
+            return nullptr;
+        }
+    }
+
+    std::shared_ptr<const CoefficientBank<SampleType>> bank = std::make_shared<CoefficientBank<SampleType>>(sampleRate);
+    banks.push_back(bank);
+
+    return bank;
+}
+
+template std::shared_ptr<const CoefficientBank<float>> CoefficientBankCache::getBank<float>(double);
+template std::shared_ptr<const CoefficientBank<double>> CoefficientBankCache::getBank<double>(double);
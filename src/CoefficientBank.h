@@ -0,0 +1,77 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <memory>
+#include <vector>
+
+// Ready-made cut filter sections for every cutoff on the "Low Cut Freq" / "High Cut Freq"
+// grid (20 Hz to 20 kHz in 1 Hz steps) at one sample rate, plus K and A tables for the peak
+// band. An automation sweep then becomes a table lookup instead of a design.
+template <typename SampleType>
+class CoefficientBank
+{
+public:
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float maxFrequency = 20000.0f;
+    static constexpr float frequencyStep = 1.0f;
+
+    static constexpr float minGainInDecibels = -24.0f;
+    static constexpr float maxGainInDecibels = 24.0f;
+    static constexpr float gainStepInDecibels = 0.1f;
+
+    // Sections of orders 2, 4, 6 and 8 stored back to back, 1 + 2 + 3 + 4 of them
+    static constexpr int numSectionsPerCutoff = 10;
+    static constexpr int numCoefficientsPerSection = 5;
+
+    explicit CoefficientBank(double sampleRate);
+
+    // The 'order / 2' sections for a cutoff on the grid, 5 values each, or nullptr if
+    // 'frequency' doesn't sit on the grid
+    const SampleType *getCutSections(float frequency, int order, bool isHighPass) const;
+
+    // Interpolated between grid points for values that don't land on one
+    double getPeakK(float frequency) const;
+    double getPeakA(float gainInDecibels) const;
+
+    double getSampleRate() const { return sampleRate; }
+    size_t getMemoryUsage() const;
+    double getBuildTimeSeconds() const { return buildTimeSeconds; }
+
+    // What a bank would take before building one
+    static size_t getExpectedMemoryUsage();
+
+private:
+    double sampleRate;
+    double buildTimeSeconds = 0.0;
+
+    std::vector<SampleType> highPassSections, lowPassSections;
+    std::vector<double> peakK, peakA;
+
+    static int getNumFrequencies();
+    static double interpolate(const std::vector<double> &table, float value, float minValue, float step);
+
+    JUCE_DECLARE_NON_COPYABLE(CoefficientBank)
+};
+
+// Process-wide home of the banks, so every instance at the same sample rate shares one.
+// Banks nobody uses any more are dropped when room is needed for a new one; if the budget
+// still doesn't allow it, no bank is handed out and callers design filters directly.
+class CoefficientBankCache
+{
+public:
+    static constexpr size_t maxMemoryBytes = 64 * 1024 * 1024;
+
+    template <typename SampleType>
+    std::shared_ptr<const CoefficientBank<SampleType>> getBank(double sampleRate);
+
+    size_t getMemoryUsage() const;
+
+private:
+    juce::CriticalSection lock;
+    std::vector<std::shared_ptr<const CoefficientBank<float>>> floatBanks;
+    std::vector<std::shared_ptr<const CoefficientBank<double>>> doubleBanks;
+
+    size_t getMemoryUsageLocked() const;
+    void removeUnusedBanksLocked();
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <array>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+// Heap bytes owned by a frame, for the memory footprint. Types without an overload count as 0.
+template <typename T>
+size_t getFrameHeapBytes(const T &)
+{
+    return 0;
+}
+
+inline size_t getFrameHeapBytes(const juce::AudioBuffer<float> &buffer)
+{
+    return (size_t)buffer.getNumChannels() * ((size_t)buffer.getNumSamples() * sizeof(float) + sizeof(float *));
+}
+
+inline size_t getFrameHeapBytes(const std::vector<float> &vector)
+{
+    return vector.capacity() * sizeof(float);
+}
+
+// Single-producer, single-consumer queue of frames. Every slot is allocated up front by
+// prepare(), and frames are swapped in and out rather than copied, so as long as both sides
+// hand in frames shaped like the prototype, nothing is ever allocated after prepare().
+// When full, push() drops the new frame; drops and empty pulls are counted.
+template <typename T>
+class FrameChannel
+{
+public:
+    static constexpr int defaultCapacity = 4;
+
+    FrameChannel()
+    {
+        prepare(defaultCapacity, T{});
+    }
+
+    // Not thread safe, call before either side starts. Note that juce::AbstractFifo keeps
+    // one slot free, so 'capacity - 1' frames fit at once.
+    void prepare(int capacity, const T &prototype)
+    {
+        jassert(capacity > 1);
+
+        slots.assign((size_t)capacity, prototype);
+        slots.shrink_to_fit();
+        fifo.setTotalSize(capacity);
+        fifo.reset();
+
+        numOverflows.store(0);
+        numUnderflows.store(0);
+    }
+
+    // Producer side. On success 'frame' comes back holding a free slot's old contents.
+    bool push(T &frame)
+    {
+        auto write = fifo.write(1);
+
+        if (write.blockSize1 > 0)
+        {
+            std::swap(slots[(size_t)write.startIndex1], frame);
+            return true;
+        }
+
+        numOverflows.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Consumer side. On success 'frame' goes back into the channel in place of the one taken out.
+    bool pull(T &frame)
+    {
+        auto read = fifo.read(1);
+
+        if (read.blockSize1 > 0)
+        {
+            std::swap(slots[(size_t)read.startIndex1], frame);
+            return true;
+        }
+
+        numUnderflows.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    int getNumAvailableForReading() const { return fifo.getNumReady(); }
+    int getCapacity() const { return fifo.getTotalSize(); }
+
+    // Frames dropped because the consumer fell behind, and pulls that found nothing
+    juce::uint64 getNumOverflows() const { return numOverflows.load(std::memory_order_relaxed); }
+    juce::uint64 getNumUnderflows() const { return numUnderflows.load(std::memory_order_relaxed); }
+
+    size_t getMemoryUsage() const
+    {
+        auto bytes = slots.capacity() * sizeof(T);
+
+        for (const auto &slot : slots)
+            bytes += getFrameHeapBytes(slot);
+
+        return bytes;
+    }
+
+private:
+    std::vector<T> slots;
+    juce::AbstractFifo fifo{defaultCapacity};
+
+    std::atomic<juce::uint64> numOverflows{0}, numUnderflows{0};
+};
+
+// Latest-wins triple buffer, for display frames where only the newest one matters. The producer
+// fills getWriteBuffer() and publishes it; the consumer acquires whatever was published last.
+// Neither side ever waits, and a frame published before the last one was read replaces it.
+template <typename T>
+class LatestFrame
+{
+public:
+    LatestFrame()
+    {
+        prepare(T{});
+    }
+
+    // Not thread safe, call before either side starts
+    void prepare(const T &prototype)
+    {
+        for (auto &slot : slots)
+            slot = prototype;
+
+        writeIndex = 0;
+        readIndex = 1;
+        shared.store(2);
+
+        numOverwritten.store(0);
+        numUnderflows.store(0);
+    }
+
+    // Producer side
+    T &getWriteBuffer() { return slots[(size_t)writeIndex]; }
+
+    void publish()
+    {
+        auto previous = shared.exchange(writeIndex | freshBit, std::memory_order_acq_rel);
+
+        if ((previous & freshBit) != 0)
+            numOverwritten.fetch_add(1, std::memory_order_relaxed);
+
+        writeIndex = previous & indexMask;
+    }
+
+    // Consumer side. Returns false, leaving getReadBuffer() as it was, if nothing new was published.
+    bool acquire()
+    {
+        if ((shared.load(std::memory_order_relaxed) & freshBit) == 0)
+        {
+            numUnderflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    // The consumer may swap this out, as long as what goes back is shaped like the prototype
+    T &getReadBuffer() { return slots[(size_t)readIndex]; }
+
+    // Frames replaced before the consumer saw them, and acquires that found nothing new
+    juce::uint64 getNumOverwritten() const { return numOverwritten.load(std::memory_order_relaxed); }
+    juce::uint64 getNumUnderflows() const { return numUnderflows.load(std::memory_order_relaxed); }
+
+    size_t getMemoryUsage() const
+    {
+        size_t bytes = 0;
+
+        for (const auto &slot : slots)
+            bytes += getFrameHeapBytes(slot);
+
+        return bytes;
+    }
+
+private:
+    static constexpr int freshBit = 4;
+    static constexpr int indexMask = 3;
+
+    std::array<T, 3> slots;
+
+    // Each side owns one slot, the third is in 'shared' with a flag saying whether it's unread
+    int writeIndex = 0, readIndex = 1;
+    std::atomic<int> shared{2};
+
+    std::atomic<juce::uint64> numOverwritten{0}, numUnderflows{0};
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+
+// How long something took over its last 'windowSize' runs, as a histogram with log-spaced
+// buckets. Any number of threads can add and read at once; each run is one atomic slot in a
+// ring, so a reader may see a mix of old and new runs but never a torn value.
+class FrameTimeHistogram
+{
+public:
+    static constexpr int windowSize = 256; // About four seconds at 60 frames a second
+    static constexpr int numBuckets = 10;
+
+    // Upper edge of bucket i in milliseconds, 0.125 ms doubling up to 32 ms, then everything above
+    static double getBucketLimit(int bucket)
+    {
+        return bucket < numBuckets - 1 ? 0.125 * (double)(1 << bucket) : std::numeric_limits<double>::infinity();
+    }
+
+    struct Summary
+    {
+        std::array<int, numBuckets> counts{};
+        int numRuns{0};
+        double mean{0}, median{0}, percentile95{0}, max{0};
+    };
+
+    void add(double milliseconds)
+    {
+        auto index = writeCount.fetch_add(1, std::memory_order_relaxed) % windowSize;
+        runs[(size_t)index].store((float)milliseconds, std::memory_order_relaxed);
+    }
+
+    Summary getSummary() const
+    {
+        Summary summary;
+        std::array<float, windowSize> sorted;
+
+        summary.numRuns = (int)std::min<juce::uint64>(writeCount.load(std::memory_order_relaxed), windowSize);
+
+        for (int i = 0; i < summary.numRuns; i++)
+        {
+            auto milliseconds = runs[(size_t)i].load(std::memory_order_relaxed);
+            sorted[(size_t)i] = milliseconds;
+            summary.mean += milliseconds;
+
+            int bucket = 0;
+
+            while (bucket < numBuckets - 1 && milliseconds >= getBucketLimit(bucket))
+                bucket++;
+
+            summary.counts[(size_t)bucket]++;
+        }
+
+        if (summary.numRuns == 0)
+            return summary;
+
+        std::sort(sorted.begin(), sorted.begin() + summary.numRuns);
+
+        summary.mean /= summary.numRuns;
+        summary.median = sorted[(size_t)(summary.numRuns / 2)];
+        summary.percentile95 = sorted[(size_t)((summary.numRuns * 95) / 100)];
+        summary.max = sorted[(size_t)(summary.numRuns - 1)];
+
+        return summary;
+    }
+
+    void reset()
+    {
+        writeCount.store(0, std::memory_order_relaxed);
+    }
+
+    // Adds the time from construction to destruction. A null histogram records nothing.
+    struct ScopedTimer
+    {
+        explicit ScopedTimer(FrameTimeHistogram *h) : histogram(h),
+                                                     startTicks(h != nullptr ? juce::Time::getHighResolutionTicks() : 0)
+        {
+        }
+
+        ~ScopedTimer()
+        {
+            if (histogram != nullptr)
+                histogram->add(1000.0 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks));
+        }
+
+        FrameTimeHistogram *histogram;
+        juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+private:
+    std::array<std::atomic<float>, windowSize> runs{};
+    std::atomic<juce::uint64> writeCount{0};
+};
+
+// Where an instance's display time goes. The message thread stages are what an open editor
+// costs the host's GUI; the worker stages run on the analyzer pool, listed for comparison.
+struct FrameTimings
+{
+    enum Stage
+    {
+        // Message thread
+        timerCallback,      // ResponseCurveComponent picking up the snapshot and path
+        curvePaintResponse, // ResponseCurveComponent::paint turning the response into a path
+        curvePaintStroke,   // ResponseCurveComponent::paint drawing the grid and both paths
+        sliderPaint,        // One rotary slider's paint
+
+        // Analyzer worker pool
+        fifoDrain,      // Pulling the analyzer FIFO into the FFT window
+        fft,            // Window, FFT and conversion to decibels
+        responseUpdate, // Redesigning and sampling the response curve
+        pathGeneration, // Building the analyzer path from the spectrum
+
+        numStages
+    };
+
+    static const char *getStageName(Stage stage)
+    {
+        static const char *const names[numStages] = {
+            "Timer callback", "Curve paint: response", "Curve paint: stroke", "Slider paint",
+            "FIFO drain", "FFT", "Response update", "Path generation"};
+
+        return names[stage];
+    }
+
+    static bool isOnMessageThread(Stage stage) { return stage < fifoDrain; }
+
+    FrameTimeHistogram &operator[](Stage stage) { return stages[(size_t)stage]; }
+    const FrameTimeHistogram &operator[](Stage stage) const { return stages[(size_t)stage]; }
+
+    void reset()
+    {
+        for (auto &stage : stages)
+            stage.reset();
+    }
+
+private:
+    std::array<FrameTimeHistogram, numStages> stages;
+};
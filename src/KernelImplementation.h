@@ -0,0 +1,388 @@
+// Kernel bodies, included once by each variant's translation unit inside its own namespace:
+//
+//     namespace Kernels::avx2
+//     {
+//     constexpr int vectorBytes = 32;
+//     #include "KernelImplementation.h"
+//     }
+//
+// so the same source is compiled for every instruction set. Each unit defines 'vectorBytes',
+// the width of its widest vectors, before the include. No include guard, and nothing
+// from outside may be used in here, see Kernels.h. Names mustn't match the dispatching
+// functions in Kernels.h either, or argument-dependent lookup would find those.
+
+// Flushes values too small to matter, as juce::dsp::IIR::Filter does, so a decaying filter
+// can't end up in denormals
+template <typename SampleType>
+inline SampleType snapToZero(SampleType value)
+{
+    return (value < (SampleType)-1.0e-8 || value > (SampleType)1.0e-8) ? value : (SampleType)0;
+}
+
+template <typename SampleType>
+struct SectionState
+{
+    SampleType b0, b1, b2, a1, a2, s1, s2;
+
+    explicit SectionState(const BiquadSection<SampleType> &section) : b0(section.b0), b1(section.b1), b2(section.b2),
+                                                                      a1(section.a1), a2(section.a2),
+                                                                      s1(section.state[0]), s2(section.state[1])
+    {
+    }
+
+    SectionState(const BiquadSection<SampleType> &section, SampleType state1, SampleType state2)
+        : b0(section.b0), b1(section.b1), b2(section.b2), a1(section.a1), a2(section.a2), s1(state1), s2(state2)
+    {
+    }
+
+    // The terms that don't depend on y are summed first, so y only has one multiply-add to
+    // go through on its way to the next sample, fused or not
+    SampleType process(SampleType x)
+    {
+        auto y = b0 * x + s1;
+        s1 = (b1 * x + s2) - a1 * y;
+        s2 = b2 * x - a2 * y;
+        return y;
+    }
+
+    void store(const BiquadSection<SampleType> &section) const
+    {
+        section.state[0] = snapToZero(s1);
+        section.state[1] = snapToZero(s2);
+    }
+};
+
+// A biquad is one long chain of dependent multiply-adds, so a single section leaves most of
+// the core idle. Sections go through in pairs instead, skewed by a sample: while the first
+// filters sample i the second filters sample i - 1, and the two recursions overlap.
+template <typename SampleType>
+void filterCascade(SampleType *samples, int numSamples, const BiquadSection<SampleType> *sections, int numSections)
+{
+    if (numSamples <= 0)
+        return;
+
+    int s = 0;
+
+    for (; s + 1 < numSections; s += 2)
+    {
+        SectionState<SampleType> first(sections[s]), second(sections[s + 1]);
+
+        auto pending = first.process(samples[0]);
+
+        for (int i = 1; i < numSamples; i++)
+        {
+            auto y = first.process(samples[i]);
+            samples[i - 1] = second.process(pending);
+            pending = y;
+        }
+
+        samples[numSamples - 1] = second.process(pending);
+
+        first.store(sections[s]);
+        second.store(sections[s + 1]);
+    }
+
+    if (s < numSections)
+    {
+        SectionState<SampleType> last(sections[s]);
+
+        for (int i = 0; i < numSamples; i++)
+            samples[i] = last.process(samples[i]);
+
+        last.store(sections[s]);
+    }
+}
+
+// Every section in one pass, a sample at a time through the whole cascade, with the number of
+// sections fixed at compile time. The loop over sections unrolls completely and the filter state
+// stays in registers, and as each section only waits on its own state from the sample before,
+// the core overlaps one section's recursion with the next without the skew filterCascade() uses.
+template <typename SampleType, int numSections>
+void filterCascadeFixed(SampleType *samples, int numSamples, const BiquadSection<SampleType> *sections)
+{
+    if constexpr (numSections > 0)
+    {
+        SampleType b0[numSections], b1[numSections], b2[numSections], a1[numSections], a2[numSections];
+        SampleType s1[numSections], s2[numSections];
+
+        for (int s = 0; s < numSections; s++)
+        {
+            b0[s] = sections[s].b0;
+            b1[s] = sections[s].b1;
+            b2[s] = sections[s].b2;
+            a1[s] = sections[s].a1;
+            a2[s] = sections[s].a2;
+            s1[s] = sections[s].state[0];
+            s2[s] = sections[s].state[1];
+        }
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            auto x = samples[i];
+
+            for (int s = 0; s < numSections; s++)
+            {
+                auto y = b0[s] * x + s1[s];
+                s1[s] = (b1[s] * x + s2[s]) - a1[s] * y;
+                s2[s] = b2[s] * x - a2[s] * y;
+                x = y;
+            }
+
+            samples[i] = x;
+        }
+
+        for (int s = 0; s < numSections; s++)
+        {
+            sections[s].state[0] = snapToZero(s1[s]);
+            sections[s].state[1] = snapToZero(s2[s]);
+        }
+    }
+}
+
+#if defined(__GNUC__)
+// The widest vector of SampleType, as a GCC/Clang vector extension type. Loads go through
+// memcpy as the tables aren't aligned to a whole vector.
+template <typename SampleType>
+struct VectorOf
+{
+    static constexpr int size = vectorBytes / (int)sizeof(SampleType);
+
+    typedef SampleType Type __attribute__((vector_size(vectorBytes)));
+
+    static Type load(const SampleType *source)
+    {
+        Type result;
+        __builtin_memcpy(&result, source, sizeof(result));
+        return result;
+    }
+};
+#endif
+
+// Time-parallel form of a section. Over a block of L samples the output is
+//
+//     y[k] = r1[k] s1 + r2[k] s2 + sum over j <= k of h[k - j] u[j]
+//
+// where s1, s2 is the state at the start of the block, r1, r2 the section's response to a unit
+// state with no input, and h its impulse response. Each term is a multiply-add along k, so a
+// block is L + 2 vector operations with no sample waiting on the one before. Only the state
+// carries over between blocks, and the TDF2 equations give it straight from the last two
+// inputs and outputs.
+template <typename SampleType, int L>
+struct BlockSection
+{
+    SampleType b1, b2, a1, a2;
+    SampleType fromState1[L], fromState2[L];
+
+    // h, with L - 1 zeros in front, so that column j of the convolution is a plain slice
+    SampleType paddedImpulse[2 * L - 1];
+
+    explicit BlockSection(const BiquadSection<SampleType> &section) : b1(section.b1), b2(section.b2),
+                                                                      a1(section.a1), a2(section.a2)
+    {
+        SectionState<SampleType> unitState1(section, 1, 0), unitState2(section, 0, 1), impulse(section, 0, 0);
+
+        for (int k = 0; k < L - 1; k++)
+            paddedImpulse[k] = 0;
+
+        for (int k = 0; k < L; k++)
+        {
+            fromState1[k] = unitState1.process(0);
+            fromState2[k] = unitState2.process(0);
+            paddedImpulse[L - 1 + k] = impulse.process(k == 0 ? (SampleType)1 : (SampleType)0);
+        }
+    }
+
+    // The block is copied in and out, so the compiler can see it doesn't alias the tables
+    void process(SampleType *samples, SampleType &s1, SampleType &s2) const
+    {
+        SampleType u[L], y[L];
+
+        for (int k = 0; k < L; k++)
+            u[k] = samples[k];
+
+#if defined(__GNUC__)
+        // Left to itself GCC vectorises the sum along j instead, as an in-order reduction per
+        // output, which is slower than the serial filter. Spelling out the vectors keeps it on k.
+        // The sum is split four ways so the multiply-adds don't all queue behind one another.
+        using Vector = typename VectorOf<SampleType>::Type;
+        constexpr int lanes = VectorOf<SampleType>::size;
+        constexpr int numVectors = L / lanes;
+        constexpr int numPartials = 4;
+
+        Vector sums[numPartials][numVectors];
+
+        for (int v = 0; v < numVectors; v++)
+        {
+            sums[0][v] = VectorOf<SampleType>::load(fromState1 + v * lanes) * s1;
+            sums[1][v] = VectorOf<SampleType>::load(fromState2 + v * lanes) * s2;
+            sums[2][v] = Vector{};
+            sums[3][v] = Vector{};
+        }
+
+        for (int j = 0; j < L; j += numPartials)
+        {
+            for (int p = 0; p < numPartials; p++)
+            {
+                auto *column = paddedImpulse + (L - 1 - j - p);
+
+                for (int v = 0; v < numVectors; v++)
+                    sums[p][v] += VectorOf<SampleType>::load(column + v * lanes) * u[j + p];
+            }
+        }
+
+        for (int v = 0; v < numVectors; v++)
+            sums[0][v] = (sums[0][v] + sums[1][v]) + (sums[2][v] + sums[3][v]);
+
+        __builtin_memcpy(y, sums[0], sizeof(y));
+#else
+        for (int k = 0; k < L; k++)
+            y[k] = fromState1[k] * s1 + fromState2[k] * s2;
+
+        for (int j = 0; j < L; j++)
+        {
+            auto *column = paddedImpulse + (L - 1 - j);
+
+            for (int k = 0; k < L; k++)
+                y[k] += column[k] * u[j];
+        }
+#endif
+
+        s2 = b2 * u[L - 1] - a2 * y[L - 1];
+        s1 = b1 * u[L - 1] - a1 * y[L - 1] + b2 * u[L - 2] - a2 * y[L - 2];
+
+        for (int k = 0; k < L; k++)
+            samples[k] = y[k];
+    }
+};
+
+// At least 8 samples a block, more when a vector holds more
+template <typename SampleType>
+constexpr int getTimeParallelBlockLength()
+{
+    return vectorBytes / (int)sizeof(SampleType) > 8 ? vectorBytes / (int)sizeof(SampleType) : 8;
+}
+
+// Same result as filterCascade(), to rounding, but vectorised along time, one section at a
+// time. Whatever doesn't fill a whole block at the end runs serially.
+template <typename SampleType>
+void filterCascadeTimeParallel(SampleType *samples, int numSamples, const BiquadSection<SampleType> *sections, int numSections)
+{
+    constexpr int L = getTimeParallelBlockLength<SampleType>();
+    auto numBlockSamples = numSamples - numSamples % L;
+
+    for (int s = 0; s < numSections; s++)
+    {
+        const BlockSection<SampleType, L> block(sections[s]);
+        auto s1 = sections[s].state[0], s2 = sections[s].state[1];
+
+        for (int n = 0; n < numBlockSamples; n += L)
+            block.process(samples + n, s1, s2);
+
+        SectionState<SampleType> rest(sections[s], s1, s2);
+
+        for (int i = numBlockSamples; i < numSamples; i++)
+            samples[i] = rest.process(samples[i]);
+
+        rest.store(sections[s]);
+    }
+}
+
+// log2 of a positive, normal float, without calling into libm so the loop vectorises. The
+// mantissa is folded into [sqrt(1/2), sqrt(2)), where the atanh series
+// log2(m) = 2 / ln(2) (t + t^3 / 3 + t^5 / 5 + t^7 / 7), t = (m - 1) / (m + 1), is good to 1e-7.
+// The fold is done on the bits, since a conditional float multiply keeps GCC from vectorising.
+inline float fastLog2(float x)
+{
+    union
+    {
+        float f;
+        int i;
+    } bits{x};
+
+    auto exponent = ((bits.i >> 23) & 255) - 127;
+    auto mantissa = bits.i & 0x007fffff;
+
+    // Mantissas above sqrt(2) get the exponent of 1/2 instead of 1
+    auto isLarge = mantissa > 0x003504f3;
+    bits.i = mantissa | (isLarge ? 0x3f000000 : 0x3f800000);
+    exponent += isLarge ? 1 : 0;
+
+    auto m = bits.f;
+    auto t = (m - 1.0f) / (m + 1.0f);
+    auto t2 = t * t;
+    auto series = t * (2.88539008f + t2 * (0.961796694f + t2 * (0.577078016f + t2 * 0.412198583f)));
+
+    return (float)exponent + series;
+}
+
+inline void convertToDecibels(float *data, int numValues, float scale, float minusInfinityDb)
+{
+    // 20 log10(2)
+    const float decibelsPerOctave = 6.02059991f;
+    const float maxFloat = 3.40282347e+38f;
+
+    for (int i = 0; i < numValues; i++)
+    {
+        auto gain = data[i] * scale;
+        auto decibels = fastLog2(gain) * decibelsPerOctave;
+
+        // NaN fails every comparison, so it lands on the floor too. The tests are combined
+        // with '&' rather than '&&', as a branch would stop the loop vectorising.
+        auto isValid = (gain > 0.0f) & (gain <= maxFloat) & (decibels > minusInfinityDb);
+        data[i] = isValid ? decibels : minusInfinityDb;
+    }
+}
+
+inline void processCascadeFloat(float *samples, int numSamples, const BiquadSection<float> *sections, int numSections)
+{
+    filterCascade(samples, numSamples, sections, numSections);
+}
+
+inline void processCascadeDouble(double *samples, int numSamples, const BiquadSection<double> *sections, int numSections)
+{
+    filterCascade(samples, numSamples, sections, numSections);
+}
+
+inline void processCascadeTimeParallelFloat(float *samples, int numSamples, const BiquadSection<float> *sections, int numSections)
+{
+    filterCascadeTimeParallel(samples, numSamples, sections, numSections);
+}
+
+inline void processCascadeTimeParallelDouble(double *samples, int numSamples, const BiquadSection<double> *sections, int numSections)
+{
+    filterCascadeTimeParallel(samples, numSamples, sections, numSections);
+}
+
+// Measured at -O3 on a 9 section cascade. Without vector extensions the time-parallel form
+// is left to the auto-vectoriser, which doesn't get it right, and two doubles a vector
+// aren't enough to pay for the extra arithmetic.
+#if defined(__GNUC__)
+constexpr bool timeParallelIsFasterFloat = true;
+constexpr bool timeParallelIsFasterDouble = vectorBytes >= 32;
+#else
+constexpr bool timeParallelIsFasterFloat = false;
+constexpr bool timeParallelIsFasterDouble = false;
+#endif
+
+// Measured the same way, with 3, 5 and 9 sections. The fixed form is at least as quick as the
+// serial one everywhere, and beats the time-parallel one too except for float with 16 byte
+// vectors. With 64 byte vectors the two are about even for float, and one pass over the
+// samples rather than three (the chain's cuts and peak) tips it to the fixed form.
+constexpr bool fixedIsFasterFloat = !timeParallelIsFasterFloat || vectorBytes >= 32;
+constexpr bool fixedIsFasterDouble = true;
+
+constexpr Table makeTable(Variant variant)
+{
+    return {variant, processCascadeFloat, processCascadeDouble,
+            processCascadeTimeParallelFloat, processCascadeTimeParallelDouble,
+            timeParallelIsFasterFloat, timeParallelIsFasterDouble,
+            {filterCascadeFixed<float, 0>, filterCascadeFixed<float, 1>, filterCascadeFixed<float, 2>,
+             filterCascadeFixed<float, 3>, filterCascadeFixed<float, 4>, filterCascadeFixed<float, 5>,
+             filterCascadeFixed<float, 6>, filterCascadeFixed<float, 7>, filterCascadeFixed<float, 8>,
+             filterCascadeFixed<float, 9>},
+            {filterCascadeFixed<double, 0>, filterCascadeFixed<double, 1>, filterCascadeFixed<double, 2>,
+             filterCascadeFixed<double, 3>, filterCascadeFixed<double, 4>, filterCascadeFixed<double, 5>,
+             filterCascadeFixed<double, 6>, filterCascadeFixed<double, 7>, filterCascadeFixed<double, 8>,
+             filterCascadeFixed<double, 9>},
+            fixedIsFasterFloat, fixedIsFasterDouble, convertToDecibels};
+}
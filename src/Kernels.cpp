@@ -0,0 +1,139 @@
+#include "Kernels.h"
+
+#include <juce_core/juce_core.h>
+
+#include <atomic>
+
+#ifndef EQUALIZER_X86_KERNELS
+#define EQUALIZER_X86_KERNELS 0
+#endif
+
+// The baseline is built with this file's own flags
+namespace Kernels::baseline
+{
+constexpr int vectorBytes = 16;
+#include "KernelImplementation.h"
+} // namespace Kernels::baseline
+
+namespace Kernels
+{
+#if EQUALIZER_X86_KERNELS
+const Table &getAVX2Table();
+const Table &getAVX512Table();
+#endif
+
+namespace
+{
+constexpr Table baselineTable = baseline::makeTable(Variant::baseline);
+
+const Table *getTableFor(Variant variant)
+{
+    switch (variant)
+    {
+#if EQUALIZER_X86_KERNELS
+    case Variant::avx2:
+        return &getAVX2Table();
+    case Variant::avx512:
+        return &getAVX512Table();
+#endif
+    case Variant::baseline:
+        return &baselineTable;
+    default:
+        return nullptr;
+    }
+}
+
+const Table *chooseTable()
+{
+    auto forced = juce::SystemStats::getEnvironmentVariable("EQUALIZER_KERNELS", {}).trim().toLowerCase();
+
+    if (forced.isNotEmpty())
+    {
+        for (int i = 0; i < numVariants; i++)
+        {
+            auto variant = (Variant)i;
+
+            if (forced == getVariantName(variant) && isSupported(variant))
+                return getTableFor(variant);
+        }
+
+        DBG("EQUALIZER_KERNELS=" << forced << " isn't supported here, picking automatically");
+    }
+
+    return getTableFor(getBestSupportedVariant());
+}
+
+std::atomic<const Table *> currentTable{nullptr};
+} // namespace
+
+const Table &getTable()
+{
+    auto *table = currentTable.load(std::memory_order_acquire);
+
+    if (table == nullptr)
+    {
+        // Two threads may both get here the first time round; they pick the same table
+        table = chooseTable();
+
+        const Table *expected = nullptr;
+
+        if (!currentTable.compare_exchange_strong(expected, table, std::memory_order_acq_rel))
+            table = expected;
+    }
+
+    return *table;
+}
+
+bool setVariant(Variant variant)
+{
+    if (!isSupported(variant))
+        return false;
+
+    currentTable.store(getTableFor(variant), std::memory_order_release);
+    return true;
+}
+
+bool isSupported(Variant variant)
+{
+    switch (variant)
+    {
+    case Variant::baseline:
+        return true;
+#if EQUALIZER_X86_KERNELS
+    case Variant::avx2:
+        return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+    case Variant::avx512:
+        return juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512VL() &&
+               juce::SystemStats::hasAVX512BW() && juce::SystemStats::hasAVX512DQ() &&
+               juce::SystemStats::hasFMA3();
+#endif
+    default:
+        return false;
+    }
+}
+
+Variant getBestSupportedVariant()
+{
+    for (auto variant : {Variant::avx512, Variant::avx2})
+    {
+        if (isSupported(variant))
+            return variant;
+    }
+
+    return Variant::baseline;
+}
+
+const char *getVariantName(Variant variant)
+{
+    switch (variant)
+    {
+    case Variant::avx2:
+        return "avx2";
+    case Variant::avx512:
+        return "avx512";
+    case Variant::baseline:
+    default:
+        return "baseline";
+    }
+}
+} // namespace Kernels
@@ -0,0 +1,150 @@
+#pragma once
+
+// The hot loops of the filter cascade and the spectrum analyzer, built once per instruction set
+// (see CMakeLists.txt) with the best one the CPU supports picked the first time they're used.
+//
+// The pick can be forced for testing and benchmarking, either with setVariant() or by setting
+// the EQUALIZER_KERNELS environment variable to a variant name ("baseline", "avx2", "avx512")
+// before the plugin loads. An unsupported choice falls back to the automatic pick.
+//
+// This header is included by the per-variant translation units, which are compiled with their
+// own instruction set flags, so it mustn't pull in anything with inline code (JUCE, the
+// standard library) that the linker could merge with a copy built for another instruction set.
+namespace Kernels
+{
+enum class Variant
+{
+    baseline, // Whatever the target's default flags allow: SSE2 on x86-64, NEON on ARM64
+    avx2,     // AVX2 and FMA
+    avx512    // AVX-512 F, VL, BW and DQ, with FMA
+};
+
+constexpr int numVariants = 3;
+
+// The most sections the fixed-count cascades below are built for: both cuts at 48 dB/oct
+// and the peak
+constexpr int maxFixedSections = 9;
+
+// One biquad, normalised as b0, b1, b2, a1, a2 like juce::dsp::IIR::Coefficients, with its
+// transposed direct form II state (two values) on the channel being processed
+template <typename SampleType>
+struct BiquadSection
+{
+    SampleType b0, b1, b2, a1, a2;
+    SampleType *state;
+};
+
+struct Table
+{
+    Variant variant;
+
+    // Filters 'samples' in place through each section in turn, updating their state
+    void (*processCascadeFloat)(float *samples, int numSamples, const BiquadSection<float> *sections, int numSections);
+    void (*processCascadeDouble)(double *samples, int numSamples, const BiquadSection<double> *sections, int numSections);
+
+    // Same, but vectorised along time rather than run a sample at a time, see
+    // processCascadeTimeParallel() below
+    void (*processCascadeTimeParallelFloat)(float *samples, int numSamples, const BiquadSection<float> *sections, int numSections);
+    void (*processCascadeTimeParallelDouble)(double *samples, int numSamples, const BiquadSection<double> *sections, int numSections);
+
+    // Whether the time-parallel form is the quicker one here, which processCascade() goes by
+    bool timeParallelIsFasterFloat, timeParallelIsFasterDouble;
+
+    // The whole cascade in one pass, one function per number of sections, see
+    // processCascadeFixed() below
+    void (*processFixedCascadeFloat[maxFixedSections + 1])(float *samples, int numSamples, const BiquadSection<float> *sections);
+    void (*processFixedCascadeDouble[maxFixedSections + 1])(double *samples, int numSamples, const BiquadSection<double> *sections);
+
+    // Whether that beats processCascade() here, which processCascadeFixed() goes by
+    bool fixedIsFasterFloat, fixedIsFasterDouble;
+
+    // data[i] = 20 log10(data[i] * scale), with anything at or below 'minusInfinityDb', zero,
+    // negative, infinite or NaN coming out as 'minusInfinityDb'. Accurate to about 1e-4 dB,
+    // which is plenty for display.
+    void (*gainToDecibels)(float *data, int numValues, float scale, float minusInfinityDb);
+};
+
+// The table in use. Safe from any thread; the first call does the CPU check.
+const Table &getTable();
+
+// Returns false, leaving the current table alone, if the CPU (or this build) doesn't support it
+bool setVariant(Variant variant);
+bool isSupported(Variant variant);
+
+// The automatic pick, ignoring setVariant() and the environment variable
+Variant getBestSupportedVariant();
+
+const char *getVariantName(Variant variant);
+
+// Filters 'samples' in place through the sections, in whichever form is quicker on this CPU
+inline void processCascade(float *samples, int numSamples, const BiquadSection<float> *sections, int numSections)
+{
+    auto &table = getTable();
+    (table.timeParallelIsFasterFloat ? table.processCascadeTimeParallelFloat : table.processCascadeFloat)(samples, numSamples, sections, numSections);
+}
+
+inline void processCascade(double *samples, int numSamples, const BiquadSection<double> *sections, int numSections)
+{
+    auto &table = getTable();
+    (table.timeParallelIsFasterDouble ? table.processCascadeTimeParallelDouble : table.processCascadeDouble)(samples, numSamples, sections, numSections);
+}
+
+// A sample at a time, with the sections in skewed pairs so their recursions overlap
+inline void processCascadeSerial(float *samples, int numSamples, const BiquadSection<float> *sections, int numSections)
+{
+    getTable().processCascadeFloat(samples, numSamples, sections, numSections);
+}
+
+inline void processCascadeSerial(double *samples, int numSamples, const BiquadSection<double> *sections, int numSections)
+{
+    getTable().processCascadeDouble(samples, numSamples, sections, numSections);
+}
+
+// Each section runs a block of samples at a time as a small state-space system, so the samples
+// of a block are computed side by side in vector lanes instead of waiting on one another.
+// It does more arithmetic than the serial form but has no long dependency chain, so it wins
+// wherever the vectors are wide enough to pay for it. Output matches the serial form to rounding.
+inline void processCascadeTimeParallel(float *samples, int numSamples, const BiquadSection<float> *sections, int numSections)
+{
+    getTable().processCascadeTimeParallelFloat(samples, numSamples, sections, numSections);
+}
+
+inline void processCascadeTimeParallel(double *samples, int numSamples, const BiquadSection<double> *sections, int numSections)
+{
+    getTable().processCascadeTimeParallelDouble(samples, numSamples, sections, numSections);
+}
+
+// For callers that know the number of sections at compile time. Each count has its own build
+// of the cascade that takes every sample through all the sections in one pass, with the loop
+// over them unrolled; where the time-parallel form is quicker still, that's used instead.
+template <int numSections>
+inline void processCascadeFixed(float *samples, int numSamples, const BiquadSection<float> *sections)
+{
+    static_assert(numSections >= 0 && numSections <= maxFixedSections, "No fixed cascade for this many sections");
+
+    auto &table = getTable();
+
+    if (table.fixedIsFasterFloat)
+        table.processFixedCascadeFloat[numSections](samples, numSamples, sections);
+    else
+        processCascade(samples, numSamples, sections, numSections);
+}
+
+template <int numSections>
+inline void processCascadeFixed(double *samples, int numSamples, const BiquadSection<double> *sections)
+{
+    static_assert(numSections >= 0 && numSections <= maxFixedSections, "No fixed cascade for this many sections");
+
+    auto &table = getTable();
+
+    if (table.fixedIsFasterDouble)
+        table.processFixedCascadeDouble[numSections](samples, numSamples, sections);
+    else
+        processCascade(samples, numSamples, sections, numSections);
+}
+
+inline void gainToDecibels(float *data, int numValues, float scale, float minusInfinityDb)
+{
+    getTable().gainToDecibels(data, numValues, scale, minusInfinityDb);
+}
+} // namespace Kernels
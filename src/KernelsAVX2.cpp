@@ -0,0 +1,19 @@
+// The kernels built for AVX2 and FMA. CMakeLists.txt adds this file, with the matching
+// compiler flags, on x86-64 only.
+
+#include "Kernels.h"
+
+namespace Kernels::avx2
+{
+constexpr int vectorBytes = 32;
+#include "KernelImplementation.h"
+} // namespace Kernels::avx2
+
+namespace Kernels
+{
+const Table &getAVX2Table()
+{
+    static constexpr Table table = avx2::makeTable(Variant::avx2);
+    return table;
+}
+} // namespace Kernels
@@ -0,0 +1,19 @@
+// The kernels built for AVX-512. CMakeLists.txt adds this file, with the matching
+// compiler flags, on x86-64 only.
+
+#include "Kernels.h"
+
+namespace Kernels::avx512
+{
+constexpr int vectorBytes = 64;
+#include "KernelImplementation.h"
+} // namespace Kernels::avx512
+
+namespace Kernels
+{
+const Table &getAVX512Table()
+{
+    static constexpr Table table = avx512::makeTable(Variant::avx512);
+    return table;
+}
+} // namespace Kernels
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+// Readings published by the audio thread, read by the editor. Everything is a plain atomic
+// float, so either side can read or write at any time without locks.
+struct MeterReadings
+{
+    static constexpr float floorDecibels = -100.0f;
+
+    struct Tap
+    {
+        // Highest peak since the reader last took it, as gain. Take with takePeak().
+        std::atomic<float> peak{0.0f};
+
+        // Over the last 300 ms, as gain
+        std::atomic<float> rms{0.0f};
+
+        float takePeak() { return peak.exchange(0.0f, std::memory_order_relaxed); }
+    };
+
+    Tap input, output;
+
+    // ITU-R BS.1770 loudness of the output in LUFS, ungated: momentary over 400 ms,
+    // short-term over 3 s
+    std::atomic<float> momentaryLoudness{floorDecibels};
+    std::atomic<float> shortTermLoudness{floorDecibels};
+};
+
+// One BS.1770 K-weighting section, transposed direct form II in double, since the high-pass
+// stage sits at 38 Hz where float state loses too much precision.
+struct KWeightingSection
+{
+    double b0{1}, b1{0}, b2{0}, a1{0}, a2{0};
+    double s1{0}, s2{0};
+
+    double process(double x)
+    {
+        auto y = b0 * x + s1;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
+        return y;
+    }
+
+    void reset() { s1 = s2 = 0; }
+};
+
+// The two K-weighting stages (a +4 dB shelf around 1.7 kHz, then a 38 Hz high-pass),
+// redesigned for any sample rate from the analogue prototype as libebur128 does
+inline std::array<KWeightingSection, 2> makeKWeighting(double sampleRate)
+{
+    const double pi = 3.14159265358979323846;
+    std::array<KWeightingSection, 2> sections;
+
+    {
+        const double f0 = 1681.974450955533, gainInDecibels = 3.999843853973347, Q = 0.7071752369554196;
+
+        auto K = std::tan(pi * f0 / sampleRate);
+        auto Vh = std::pow(10.0, gainInDecibels / 20.0);
+        auto Vb = std::pow(Vh, 0.4996667741545416);
+        auto a0 = 1.0 + K / Q + K * K;
+
+        auto &s = sections[0];
+        s.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        s.b1 = 2.0 * (K * K - Vh) / a0;
+        s.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        s.a1 = 2.0 * (K * K - 1.0) / a0;
+        s.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+
+    {
+        const double f0 = 38.13547087602444, Q = 0.5003270373238773;
+
+        auto K = std::tan(pi * f0 / sampleRate);
+        auto a0 = 1.0 + K / Q + K * K;
+
+        auto &s = sections[1];
+        s.b0 = 1.0;
+        s.b1 = -2.0;
+        s.b2 = 1.0;
+        s.a1 = 2.0 * (K * K - 1.0) / a0;
+        s.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+
+    return sections;
+}
+
+// Sum of squares with four independent accumulators, so consecutive samples don't wait on
+// each other and the loop runs at the machine's full multiply-add rate
+template <typename SampleType>
+double getSumOfSquares(const SampleType *data, int numSamples)
+{
+    SampleType sums[4] = {};
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        sums[0] += data[i] * data[i];
+        sums[1] += data[i + 1] * data[i + 1];
+        sums[2] += data[i + 2] * data[i + 2];
+        sums[3] += data[i + 3] * data[i + 3];
+    }
+
+    for (; i < numSamples; i++)
+        sums[0] += data[i] * data[i];
+
+    return (double)sums[0] + (double)sums[1] + (double)sums[2] + (double)sums[3];
+}
+
+// Measures one point in the signal path: peak, RMS and, optionally, loudness. Everything is
+// accumulated over 100 ms steps, the BS.1770 block grid, and published once per step; the
+// peak is published every block. Call prepare() off the audio thread; process() never allocates.
+template <typename SampleType>
+class LevelMeter
+{
+public:
+    void prepare(double sampleRate, int numChannels, bool shouldMeasureLoudness)
+    {
+        measureLoudness = shouldMeasureLoudness;
+        stepLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+
+        auto kWeighting = makeKWeighting(sampleRate);
+        channels.assign((size_t)numChannels, kWeighting);
+
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto &channel : channels)
+        {
+            for (auto &section : channel)
+                section.reset();
+        }
+
+        positionInStep = 0;
+        stepSquares = 0.0;
+        stepWeightedSquares = 0.0;
+
+        steps.fill({});
+        nextStep = 0;
+        numStepsFilled = 0;
+    }
+
+    void process(const juce::AudioBuffer<SampleType> &buffer, MeterReadings::Tap &tap, MeterReadings *loudness)
+    {
+        auto numChannels = juce::jmin(buffer.getNumChannels(), (int)channels.size());
+        auto numSamples = buffer.getNumSamples();
+
+        if (numChannels == 0 || numSamples == 0)
+            return;
+
+        // Peak of the whole block, over every channel
+        SampleType peak = 0;
+
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(ch), numSamples);
+            peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+        }
+
+        publishPeak(tap, (float)peak);
+
+        // Then the block is cut at the 100 ms step boundaries
+        for (int start = 0; start < numSamples;)
+        {
+            auto length = juce::jmin(numSamples - start, stepLength - positionInStep);
+
+            for (int ch = 0; ch < numChannels; ch++)
+                stepSquares += getSumOfSquares(buffer.getReadPointer(ch, start), length);
+
+            if (measureLoudness)
+            {
+                // Channels go through in pairs, two independent recursions keep the FPU busier
+                int ch = 0;
+
+                for (; ch + 1 < numChannels; ch += 2)
+                {
+                    stepWeightedSquares += getWeightedSumOfSquares(channels[(size_t)ch], buffer.getReadPointer(ch, start),
+                                                                   channels[(size_t)ch + 1], buffer.getReadPointer(ch + 1, start),
+                                                                   length);
+                }
+
+                if (ch < numChannels)
+                    stepWeightedSquares += getWeightedSumOfSquares(channels[(size_t)ch], buffer.getReadPointer(ch, start), length);
+            }
+
+            start += length;
+            positionInStep += length;
+
+            if (positionInStep == stepLength)
+                finishStep(numChannels, tap, loudness);
+        }
+    }
+
+private:
+    static constexpr int rmsSteps = 3;        // 300 ms
+    static constexpr int momentarySteps = 4;  // 400 ms
+    static constexpr int shortTermSteps = 30; // 3 s
+
+    struct Step
+    {
+        double meanSquare{0}, weightedMeanSquare{0};
+    };
+
+    bool measureLoudness = false;
+    int stepLength = 4800;
+    std::vector<std::array<KWeightingSection, 2>> channels;
+
+    int positionInStep = 0;
+    double stepSquares = 0.0, stepWeightedSquares = 0.0;
+
+    // Ring of the last 'shortTermSteps' steps
+    std::array<Step, shortTermSteps> steps;
+    int nextStep = 0, numStepsFilled = 0;
+
+    // Both K-weighting stages and the square run in one pass, nothing is written back
+    static double getWeightedSumOfSquares(std::array<KWeightingSection, 2> &kWeighting, const SampleType *data, int numSamples)
+    {
+        auto &shelf = kWeighting[0];
+        auto &highPass = kWeighting[1];
+        double sum = 0.0;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            auto y = highPass.process(shelf.process((double)data[i]));
+            sum += y * y;
+        }
+
+        return sum;
+    }
+
+    static double getWeightedSumOfSquares(std::array<KWeightingSection, 2> &kWeightingA, const SampleType *dataA,
+                                          std::array<KWeightingSection, 2> &kWeightingB, const SampleType *dataB,
+                                          int numSamples)
+    {
+        double sumA = 0.0, sumB = 0.0;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            auto a = kWeightingA[1].process(kWeightingA[0].process((double)dataA[i]));
+            auto b = kWeightingB[1].process(kWeightingB[0].process((double)dataB[i]));
+            sumA += a * a;
+            sumB += b * b;
+        }
+
+        return sumA + sumB;
+    }
+
+    static void publishPeak(MeterReadings::Tap &tap, float peak)
+    {
+        auto current = tap.peak.load(std::memory_order_relaxed);
+
+        while (peak > current && !tap.peak.compare_exchange_weak(current, peak, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    double getMean(int count, double Step::*member) const
+    {
+        count = juce::jmin(count, numStepsFilled);
+        double sum = 0.0;
+
+        for (int i = 1; i <= count; i++)
+            sum += steps[(size_t)((nextStep - i + shortTermSteps) % shortTermSteps)].*member;
+
+        return count > 0 ? sum / count : 0.0;
+    }
+
+    void finishStep(int numChannels, MeterReadings::Tap &tap, MeterReadings *loudness)
+    {
+        // RMS is averaged over the channels, loudness sums them (BS.1770 weights of 1, which
+        // is right for everything but the surround channels of a 5.1 layout)
+        auto &step = steps[(size_t)nextStep];
+        step.meanSquare = stepSquares / ((double)stepLength * numChannels);
+        step.weightedMeanSquare = stepWeightedSquares / (double)stepLength;
+
+        nextStep = (nextStep + 1) % shortTermSteps;
+        numStepsFilled = juce::jmin(numStepsFilled + 1, shortTermSteps);
+
+        tap.rms.store((float)std::sqrt(getMean(rmsSteps, &Step::meanSquare)), std::memory_order_relaxed);
+
+        if (measureLoudness && loudness != nullptr)
+        {
+            loudness->momentaryLoudness.store(toLoudness(getMean(momentarySteps, &Step::weightedMeanSquare)), std::memory_order_relaxed);
+            loudness->shortTermLoudness.store(toLoudness(getMean(shortTermSteps, &Step::weightedMeanSquare)), std::memory_order_relaxed);
+        }
+
+        positionInStep = 0;
+        stepSquares = 0.0;
+        stepWeightedSquares = 0.0;
+    }
+
+    static float toLoudness(double meanSquare)
+    {
+        if (meanSquare <= 0.0)
+            return MeterReadings::floorDecibels;
+
+        return juce::jmax(MeterReadings::floorDecibels, (float)(-0.691 + 10.0 * std::log10(meanSquare)));
+    }
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "ButterworthDesign.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Magnitude-matched biquads (M. Vicanek, "Matched Second Order Digital Filters", 2016). The
+// poles are the analog poles mapped through z = e^(sT), and the zeros are picked so the
+// magnitude matches the analog prototype at a few points: for the bell, at DC and at the
+// centre, where its slope (zero) is matched too; DC and the cutoff for the low-pass; the cutoff
+// for the high-pass. There's no frequency warping as with the bilinear transform, so a bell or
+// cutoff close to Nyquist stays much closer to its analog shape without oversampling, and the
+// result is still one biquad per section.
+namespace MatchedEQ
+{
+// The pole coefficients and the terms every design below shares
+struct Poles
+{
+    double a1, a2;
+    double A0, A1, A2;
+    double phi0, phi1, phi2;
+};
+
+inline Poles getPoles(double frequency, double sampleRate, double quality)
+{
+    // Clamped like the bilinear designs, so both see the same frequency
+    auto w0 = 2.0 * 3.14159265358979323846 * Butterworth::clampFrequency(frequency, sampleRate) / sampleRate;
+    auto q = 0.5 / quality;
+    auto decay = std::exp(-q * w0);
+
+    Poles p;
+
+    // Complex poles for Q above a half, real ones below
+    p.a1 = q <= 1.0 ? -2.0 * decay * std::cos(std::sqrt(1.0 - q * q) * w0)
+                    : -2.0 * decay * std::cosh(std::sqrt(q * q - 1.0) * w0);
+    p.a2 = decay * decay;
+
+    p.A0 = (1.0 + p.a1 + p.a2) * (1.0 + p.a1 + p.a2);
+    p.A1 = (1.0 - p.a1 + p.a2) * (1.0 - p.a1 + p.a2);
+    p.A2 = -4.0 * p.a2;
+
+    auto s = std::sin(0.5 * w0);
+    p.phi1 = s * s;
+    p.phi0 = 1.0 - p.phi1;
+    p.phi2 = 4.0 * p.phi0 * p.phi1;
+
+    return p;
+}
+
+// All of these write the section normalised as b0, b1, b2, a1, a2, the layout of IIR::Coefficients
+template <typename SampleType>
+void designLowPass(SampleType *coefficients, double frequency, double sampleRate, double quality)
+{
+    auto p = getPoles(frequency, sampleRate, quality);
+
+    auto R1 = (p.A0 * p.phi0 + p.A1 * p.phi1 + p.A2 * p.phi2) * quality * quality;
+    auto B0 = p.A0;
+    auto B1 = std::max(0.0, (R1 - B0 * p.phi0) / p.phi1);
+
+    auto b0 = 0.5 * (std::sqrt(B0) + std::sqrt(B1));
+
+    coefficients[0] = (SampleType)b0;
+    coefficients[1] = (SampleType)(std::sqrt(B0) - b0);
+    coefficients[2] = (SampleType)0;
+    coefficients[3] = (SampleType)p.a1;
+    coefficients[4] = (SampleType)p.a2;
+}
+
+template <typename SampleType>
+void designHighPass(SampleType *coefficients, double frequency, double sampleRate, double quality)
+{
+    auto p = getPoles(frequency, sampleRate, quality);
+
+    auto b0 = quality * std::sqrt(std::max(0.0, p.A0 * p.phi0 + p.A1 * p.phi1 + p.A2 * p.phi2)) / (4.0 * p.phi1);
+
+    coefficients[0] = (SampleType)b0;
+    coefficients[1] = (SampleType)(-2.0 * b0);
+    coefficients[2] = (SampleType)b0;
+    coefficients[3] = (SampleType)p.a1;
+    coefficients[4] = (SampleType)p.a2;
+}
+
+// Same parameters as PeakEQ, so the analog prototype is the cookbook's
+// (s^2 + s A / Q + 1) / (s^2 + s / (A Q) + 1) with A = 10^(gain / 40). R1 and R2 are the value
+// and slope the numerator of the squared magnitude needs at the centre for that to match.
+template <typename SampleType>
+void designPeak(SampleType *coefficients, double frequency, double sampleRate, double quality, double gainInDecibels)
+{
+    auto A = std::pow(10.0, gainInDecibels / 40.0);
+    auto G = A * A;
+    auto p = getPoles(frequency, sampleRate, quality * A);
+
+    auto R1 = (p.A0 * p.phi0 + p.A1 * p.phi1 + p.A2 * p.phi2) * G * G;
+    auto R2 = (-p.A0 + p.A1 + 4.0 * (p.phi0 - p.phi1) * p.A2) * G * G;
+
+    auto B0 = p.A0;
+    auto B2 = (R1 - R2 * p.phi1 - B0) / (4.0 * p.phi1 * p.phi1);
+    auto B1 = std::max(0.0, R2 + B0 + 4.0 * (p.phi1 - p.phi0) * B2);
+
+    auto W = 0.5 * (std::sqrt(B0) + std::sqrt(B1));
+    auto b0 = 0.5 * (W + std::sqrt(std::max(0.0, W * W + B2)));
+
+    coefficients[0] = (SampleType)b0;
+    coefficients[1] = (SampleType)(0.5 * (std::sqrt(B0) - std::sqrt(B1)));
+    coefficients[2] = (SampleType)(-B2 / (4.0 * b0));
+    coefficients[3] = (SampleType)p.a1;
+    coefficients[4] = (SampleType)p.a2;
+}
+
+// Butterworth::designCut with matched sections, which keep the Butterworth pole Qs
+template <typename SampleType>
+void designCut(SampleType *const *sections, int order, double frequency, double sampleRate, bool isHighPass)
+{
+    for (int s = 0; s < order / 2; s++)
+    {
+        auto quality = 1.0 / Butterworth::getDamping(order, s);
+
+        if (isHighPass)
+            designHighPass(sections[s], frequency, sampleRate, quality);
+        else
+            designLowPass(sections[s], frequency, sampleRate, quality);
+    }
+}
+} // namespace MatchedEQ
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Fractional-octave smoothing of a magnitude spectrum: each bin becomes the RMS of the bins
+// within half a band either side of it, so the window widens with frequency the way hearing
+// does. With a running sum of power the cost per bin is the same whatever the bandwidth.
+//
+// A window's edges, in bins, are its centre bin times 2^(+-1 / 2N), so they depend on the
+// number of bins and the bandwidth but not the sample rate. They're worked out once in
+// prepare(); process() doesn't allocate.
+class OctaveSmoother
+{
+public:
+    // 'bandsPerOctave' of 1 smooths over an octave, 3 over a third and so on; 0 turns it off
+    void prepare(int numberOfBins, int bandsPerOctave)
+    {
+        if (numberOfBins == numBins && bandsPerOctave == fraction)
+            return;
+
+        numBins = numberOfBins;
+        fraction = bandsPerOctave;
+
+        lowEdges.clear();
+        highEdges.clear();
+        runningPower.clear();
+
+        if (!isEnabled())
+            return;
+
+        lowEdges.resize((size_t)numBins);
+        highEdges.resize((size_t)numBins);
+        runningPower.resize((size_t)numBins + 1);
+
+        auto halfBand = std::pow(2.0, 0.5 / fraction);
+
+        for (int bin = 0; bin < numBins; bin++)
+        {
+            // Every window holds at least its own bin, and DC stays on its own
+            auto low = (int)std::floor((double)bin / halfBand + 0.5);
+            auto high = (int)std::floor((double)bin * halfBand + 0.5);
+
+            lowEdges[(size_t)bin] = std::clamp(low, bin == 0 ? 0 : 1, bin);
+            highEdges[(size_t)bin] = std::clamp(high, bin, numBins - 1);
+        }
+    }
+
+    bool isEnabled() const { return fraction > 0 && numBins > 0; }
+    int getBandsPerOctave() const { return fraction; }
+
+    // Smooths the first getNumBins() magnitudes in place
+    void process(float *magnitudes)
+    {
+        if (!isEnabled())
+            return;
+
+        // Doubles, as the sum runs over up to thousands of values that differ by 100 dB or more
+        runningPower[0] = 0.0;
+
+        for (int bin = 0; bin < numBins; bin++)
+            runningPower[(size_t)bin + 1] = runningPower[(size_t)bin] + (double)magnitudes[bin] * magnitudes[bin];
+
+        for (int bin = 0; bin < numBins; bin++)
+        {
+            auto low = lowEdges[(size_t)bin];
+            auto high = highEdges[(size_t)bin];
+
+            auto power = (runningPower[(size_t)high + 1] - runningPower[(size_t)low]) / (double)(high - low + 1);
+            magnitudes[bin] = (float)std::sqrt(std::max(power, 0.0));
+        }
+    }
+
+    int getNumBins() const { return numBins; }
+
+    size_t getMemoryUsage() const
+    {
+        return (lowEdges.capacity() + highEdges.capacity()) * sizeof(int) + runningPower.capacity() * sizeof(double);
+    }
+
+private:
+    int numBins = 0;
+    int fraction = 0;
+
+    std::vector<int> lowEdges, highEdges;
+
+    // Scratch for process(), sized by prepare()
+    std::vector<double> runningPower;
+};
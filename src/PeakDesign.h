@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ButterworthDesign.h"
+
+#include <cmath>
+
+// Peak (bell) biquad from the RBJ cookbook, written in terms of K = tan(pi * fc / fs) and
+// A = 10^(gain / 40). Both are the expensive parts and can come from a table; the rest is a
+// handful of multiplies written straight into the caller's storage.
+namespace PeakEQ
+{
+// Clamped below Nyquist like the cuts
+inline double getK(double frequency, double sampleRate)
+{
+    return std::tan(3.14159265358979323846 * Butterworth::clampFrequency(frequency, sampleRate) / sampleRate);
+}
+
+inline double getA(double gainInDecibels)
+{
+    return std::pow(10.0, gainInDecibels / 40.0);
+}
+
+// Writes the section normalised as b0, b1, b2, a1, a2, the layout of IIR::Coefficients
+template <typename SampleType>
+void designSection(SampleType *coefficients, double K, double A, double quality)
+{
+    auto K2 = K * K;
+    auto onePlusK2 = 1.0 + K2;
+    auto kTimesA = K * A / quality;
+    auto kOverA = K / (quality * A);
+    auto norm = 1.0 / (onePlusK2 + kOverA);
+
+    coefficients[0] = (SampleType)((onePlusK2 + kTimesA) * norm);
+    coefficients[1] = (SampleType)(2.0 * (K2 - 1.0) * norm);
+    coefficients[2] = (SampleType)((onePlusK2 - kTimesA) * norm);
+    coefficients[3] = coefficients[1];
+    coefficients[4] = (SampleType)((onePlusK2 - kOverA) * norm);
+}
+} // namespace PeakEQ
@@ -80,6 +80,8 @@ void RotarySliderWithLabels::paint(juce::Graphics &g)
 {
     using namespace juce;
 
+    FrameTimeHistogram::ScopedTimer timer(paintTimes);
+
     auto startAng = degreesToRadians(180.0f + 45.0f);
     auto endAng = degreesToRadians(180.0f - 45.0f) + MathConstants<float>::twoPi;
 
@@ -172,219 +174,213 @@ juce::String RotarySliderWithLabels::getDisplayString() const
     return str;
 }
 
-ResponseCurveComponent::ResponseCurveComponent(AudioPluginAudioProcessor &p) : processorRef(p),
-                                                                               leftChannelFifo(&processorRef.leftChannelFifo)
+AnalyzerPathJob::AnalyzerPathJob(AnalysisEngine &engine) : engineRef(engine)
 {
-    const auto &params = processorRef.getParameters();
+    workerPool->addClient(*this);
+}
+
+AnalyzerPathJob::~AnalyzerPathJob()
+{
+    workerPool->removeClient(*this);
+}
+
+void AnalyzerPathJob::setRenderBounds(juce::Rectangle<float> bounds)
+{
+    const juce::SpinLock::ScopedLockType sl(boundsLock);
+    renderBounds = bounds;
+}
+
+void AnalyzerPathJob::runAnalysisFrame()
+{
+    juce::Rectangle<float> bounds;
 
-    for (auto param : params)
     {
-        param->addListener(this);
+        const juce::SpinLock::ScopedLockType sl(boundsLock);
+        bounds = renderBounds;
     }
 
-    leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
-    monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+    auto snapshot = engineRef.getLatestSnapshot();
 
-    updateChain();
-    startTimerHz(60);
-}
+    if (snapshot == nullptr || snapshot->spectrum.empty() || bounds.isEmpty())
+        return;
 
-ResponseCurveComponent::~ResponseCurveComponent()
-{
-    const auto &params = processorRef.getParameters();
+    if (snapshot->spectrumIndex == lastSpectrumIndex && bounds == lastBounds && snapshot->qualityLevel == lastQualityLevel)
+        return;
+
+    // Bin width -> 48,000/2,048 = 23Hz
+    const auto binWidth = snapshot->sampleRate / (double)snapshot->fftSize;
+    const auto &quality = AnalyzerGovernor::getQuality(snapshot->qualityLevel);
+
+    // A smoothed spectrum can't change faster than its bands, so a few points a band will do,
+    // however many bins there are. 20 Hz to 20 kHz is just under ten octaves.
+    auto pathResolution = quality.pathResolution;
+    auto minPointSpacing = 0.0f;
+
+    if (snapshot->smoothingBandsPerOctave > 0)
+    {
+        const auto pointsPerBand = 4.0f;
+        pathResolution = 1;
+        minPointSpacing = juce::jmax((float)quality.pathResolution,
+                                     bounds.getWidth() / (9.97f * (float)snapshot->smoothingBandsPerOctave * pointsPerBand));
+    }
 
-    for (auto param : params)
     {
-        param->removeListener(this);
+        FrameTimeHistogram::ScopedTimer timer(&engineRef.getFrameTimings()[FrameTimings::pathGeneration]);
+        pathProducer.generatePath(snapshot->spectrum, bounds, snapshot->fftSize, binWidth, -96.0f, pathResolution, minPointSpacing);
     }
+
+    lastSpectrumIndex = snapshot->spectrumIndex;
+    lastBounds = bounds;
+    lastQualityLevel = snapshot->qualityLevel;
 }
 
-void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
+ResponseCurveComponent::ResponseCurveComponent(AudioPluginAudioProcessor &p) : processorRef(p),
+                                                                               pathJob(p.getAnalysisEngine())
 {
-    parametersChanged.set(true);
+    startTimerHz(AnalyzerWorkerPool::framesPerSecond);
+
+    // The engine keeps running while the editor is closed, so there's something to show right
+    // away. This also slows the timer down if the analyzer has been stepped down.
+    timerCallback();
 }
 
 void ResponseCurveComponent::timerCallback()
 {
-    juce::AudioBuffer<float> tempIncomingBuffer;
+    EQ_TRACE_SCOPE("timerCallback");
 
-    while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
-    {
-        if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer))
-        {
-            auto size = tempIncomingBuffer.getNumSamples();
+    auto startMs = juce::Time::getMillisecondCounterHiRes();
+    auto &engine = processorRef.getAnalysisEngine();
 
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0), monoBuffer.getReadPointer(0, size),
-                                              monoBuffer.getNumSamples() - size);
+    FrameTimeHistogram::ScopedTimer timer(&engine.getFrameTimings()[FrameTimings::timerCallback]);
 
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                                              tempIncomingBuffer.getReadPointer(0, 0), size);
+    // Both the snapshot and the path are finished work, all that's left here is drawing them
+    auto latest = engine.getLatestSnapshot();
+    auto snapshotChanged = latest != nullptr && latest != snapshot;
+    auto pathChanged = pathJob.getPath(leftChannelFFTPath);
 
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -96.0f);
-        }
-    }
-
-    // If there are FFT data buffers to pull
-    // If we can pull a buffer
-    // Generate a path
-    auto fftBounds = getRenderArea().toFloat();
-    auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
-
-    // Bin width -> 48,000/2,048 = 23Hz
-    const auto binWidth = processorRef.getSampleRate() / (double)fftSize;
-
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks())
-    {
-        std::vector<float> fftData;
+    if (snapshotChanged)
+        snapshot = std::move(latest);
 
-        if (leftChannelFFTDataGenerator.getFFTData(fftData))
-        {
-            pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -96.0f);
-        }
-    }
+    // One new column per spectrum; the history already in the image is left alone
+    auto spectrogramChanged = false;
 
-    // While there are paths that we can pull
-    // Pull as many as we can
-    // Display the most recent path
-    while (pathProducer.getNumPathsAvailable())
+    if (spectrogramMode && snapshot != nullptr && snapshot->spectrumIndex != lastSpectrogramIndex)
     {
-        pathProducer.getPath(leftChannelFFTPath);
+        spectrogram.addColumn(snapshot->spectrum, snapshot->fftSize, snapshot->sampleRate);
+        lastSpectrogramIndex = snapshot->spectrumIndex;
+        spectrogramChanged = true;
     }
 
-    if (parametersChanged.compareAndSetBool(false, true))
+    if (snapshot != nullptr && snapshot->qualityLevel != timerQualityLevel)
     {
-        // Update the monochain
-        updateChain();
+        timerQualityLevel = snapshot->qualityLevel;
+        startTimerHz(AnalyzerWorkerPool::framesPerSecond / AnalyzerGovernor::getQuality(timerQualityLevel).frameDivisor);
     }
 
     // Signal a repaint
-    repaint();
+    if (snapshotChanged || pathChanged || spectrogramChanged)
+        repaint();
+
+    // The paint this timer asks for is reported with the next callback
+    engine.getGovernor().reportMessageThreadTime(juce::Time::getMillisecondCounterHiRes() - startMs + lastPaintMilliseconds);
+    lastPaintMilliseconds = 0.0;
 }
 
-void ResponseCurveComponent::updateChain()
+size_t ResponseCurveComponent::getMemoryUsage() const
 {
-    auto chainSettings = getChainSettings(processorRef.apvts);
-
-    monoChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    monoChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    monoChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+    auto bytes = sizeof(*this);
 
-    auto peakCoefficients = makePeakFilter(chainSettings, processorRef.getSampleRate());
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, processorRef.getSampleRate());
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, processorRef.getSampleRate());
+    bytes += (size_t)(background.getWidth() * background.getHeight()) * 3;
+    bytes += pathJob.getMemoryUsage() - sizeof(pathJob);
+    bytes += spectrogram.getMemoryUsage() - sizeof(spectrogram);
 
-    updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCutFilter(monoChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+    return bytes;
 }
 
 void ResponseCurveComponent::paint(juce::Graphics &g)
 {
+    EQ_TRACE_SCOPE("ResponseCurveComponent::paint");
     using namespace juce;
 
+    auto startMs = Time::getMillisecondCounterHiRes();
+
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll(Colour(18u, 18u, 18u));
 
     auto responseArea = getRenderArea();
     auto w = responseArea.getWidth();
 
-    auto &lowcut = monoChain.get<ChainPositions::LowCut>();
-    auto &peak = monoChain.get<ChainPositions::Peak>();
-    auto &highcut = monoChain.get<ChainPositions::HighCut>();
+    Path responseCurve;
+
+    const double outputMin = responseArea.getBottom();
+    const double outputMax = responseArea.getY();
 
-    auto sampleRate = processorRef.getSampleRate();
+    auto map = [outputMin, outputMax](double input)
+    {
+        return jmap(input, -24.0, 24.0, outputMin, outputMax);
+    };
 
-    std::vector<double> mags;
-    mags.resize(w);
+    auto &timings = processorRef.getAnalysisEngine().getFrameTimings();
 
-    for (int i = 0; i < w; i++)
     {
-        double mag = 1.0f;
-        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
+        FrameTimeHistogram::ScopedTimer timer(&timings[FrameTimings::curvePaintResponse]);
 
-        if (!monoChain.isBypassed<ChainPositions::Peak>())
+        // The engine samples the response on a fixed log grid, which lines up with the x axis
+        if (!spectrogramMode && snapshot != nullptr && !snapshot->response.empty())
         {
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
+            const auto &mags = snapshot->response;
+            auto lastIndex = (double)(mags.size() - 1);
 
-        if (!monoChain.isBypassed<ChainPositions::LowCut>())
-        {
-            if (!lowcut.isBypassed<0>())
-            {
-                mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!lowcut.isBypassed<1>())
-            {
-                mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!lowcut.isBypassed<2>())
-            {
-                mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!lowcut.isBypassed<3>())
-            {
-                mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-        }
+            responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
 
-        if (!monoChain.isBypassed<ChainPositions::HighCut>())
-        {
-            if (!highcut.isBypassed<0>())
-            {
-                mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!highcut.isBypassed<1>())
-            {
-                mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!highcut.isBypassed<2>())
+            for (size_t i = 1; i < mags.size(); i++)
             {
-                mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!highcut.isBypassed<3>())
-            {
-                mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                responseCurve.lineTo(responseArea.getX() + w * (float)(i / lastIndex), map(mags[i]));
             }
         }
-
-        mags[i] = Decibels::gainToDecibels(mag);
     }
 
-    Path responseCurve;
-
-    const double outputMin = responseArea.getBottom();
-    const double outputMax = responseArea.getY();
-
-    auto map = [outputMin, outputMax](double input)
-    {
-        return jmap(input, -24.0, 24.0, outputMin, outputMax);
-    };
+    FrameTimeHistogram::ScopedTimer strokeTimer(&timings[FrameTimings::curvePaintStroke]);
 
-    responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
+    g.setColour(Colours::black);
+    g.fillRoundedRectangle(getRenderArea().toFloat(), 0.0f);
 
-    for (size_t i = 1; i < mags.size(); i++)
+    if (spectrogramMode)
     {
-        responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
+        spectrogram.draw(g, responseArea);
     }
+    else
+    {
+        g.drawImage(background, getRenderArea().toFloat());
 
-    leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
-
-    g.setColour(Colours::black);
-    g.fillRoundedRectangle(getRenderArea().toFloat(), 0.0f);
+        // The analyzer path is built relative to the render area
+        g.setColour(Colour(187u, 134u, 252u));
+        g.strokePath(leftChannelFFTPath, PathStrokeType(2.0f),
+                     AffineTransform::translation(responseArea.getX(), responseArea.getY()));
 
-    g.drawImage(background, getRenderArea().toFloat());
+        g.setColour(Colours::white);
+        g.strokePath(responseCurve, PathStrokeType(2.0f));
+    }
 
-    g.setColour(Colour(187u, 134u, 252u));
-    g.strokePath(leftChannelFFTPath, PathStrokeType(2.0f));
+    // Only shown once the governor has stepped down, so the usual view stays clean
+    if (snapshot != nullptr && snapshot->qualityLevel > 0)
+    {
+        g.setColour(Colours::grey);
+        g.setFont(11);
+        g.drawText(String("Analyzer: ") + AnalyzerGovernor::getQuality(snapshot->qualityLevel).name,
+                   responseArea.reduced(4).removeFromTop(14), Justification::topLeft, false);
+    }
 
-    g.setColour(Colours::white);
-    g.strokePath(responseCurve, PathStrokeType(2.0f));
+    lastPaintMilliseconds += Time::getMillisecondCounterHiRes() - startMs;
 }
 
 void ResponseCurveComponent::resized()
 {
     using namespace juce;
 
+    pathJob.setRenderBounds(getRenderArea().toFloat());
+    spectrogram.setSize(getRenderArea().getWidth(), getRenderArea().getHeight());
+
     background = Image(Image::PixelFormat::RGB, getWidth(), getHeight(), true);
 
     Graphics g(background);
@@ -413,6 +409,30 @@ void ResponseCurveComponent::resized()
     }
 }
 
+void ResponseCurveComponent::mouseDoubleClick(const juce::MouseEvent &)
+{
+    setSpectrogramMode(!spectrogramMode);
+}
+
+void ResponseCurveComponent::setSpectrogramMode(bool shouldShowSpectrogram)
+{
+    if (shouldShowSpectrogram == spectrogramMode)
+        return;
+
+    spectrogramMode = shouldShowSpectrogram;
+
+    if (spectrogramMode)
+    {
+        spectrogram.clear();
+
+        // Start from the next spectrum rather than repeating the current one
+        if (snapshot != nullptr)
+            lastSpectrogramIndex = snapshot->spectrumIndex;
+    }
+
+    repaint();
+}
+
 juce::Rectangle<int> ResponseCurveComponent::getRenderArea()
 {
     auto bounds = getLocalBounds();
@@ -424,6 +444,148 @@ juce::Rectangle<int> ResponseCurveComponent::getRenderArea()
     return bounds;
 }
 
+LevelMeterComponent::LevelMeterComponent(MeterReadings &readings) : meterReadings(readings)
+{
+    startTimerHz(refreshRateHz);
+}
+
+void LevelMeterComponent::updateBar(Bar &bar, MeterReadings::Tap &tap)
+{
+    auto peak = juce::Decibels::gainToDecibels(tap.takePeak(), minDecibels);
+    auto fallen = bar.peakDecibels - peakFallPerSecond / refreshRateHz;
+
+    bar.peakDecibels = juce::jmax(peak, fallen, minDecibels);
+    bar.rmsDecibels = juce::Decibels::gainToDecibels(tap.rms.load(), minDecibels);
+}
+
+void LevelMeterComponent::timerCallback()
+{
+    updateBar(input, meterReadings.input);
+    updateBar(output, meterReadings.output);
+
+    momentaryLoudness = meterReadings.momentaryLoudness.load();
+    shortTermLoudness = meterReadings.shortTermLoudness.load();
+
+    repaint();
+}
+
+void LevelMeterComponent::drawBar(juce::Graphics &g, juce::Rectangle<float> bounds, const Bar &bar, const juce::String &label)
+{
+    using namespace juce;
+
+    g.setColour(Colours::white);
+    g.setFont(12);
+    g.drawFittedText(label, bounds.removeFromBottom(14).toNearestInt(), Justification::centred, 1);
+
+    g.setColour(Colour(33u, 33u, 33u));
+    g.fillRect(bounds);
+
+    auto toY = [bounds](float decibels)
+    {
+        return jmap(decibels, minDecibels, 0.0f, bounds.getBottom(), bounds.getY());
+    };
+
+    g.setColour(Colour(3u, 218u, 197u));
+    g.fillRect(bounds.withTop(toY(bar.rmsDecibels)));
+
+    g.setColour(bar.peakDecibels > -0.1f ? Colours::red : Colour(187u, 134u, 252u));
+    g.fillRect(bounds.withTop(toY(bar.peakDecibels)).withHeight(2.0f));
+}
+
+void LevelMeterComponent::paint(juce::Graphics &g)
+{
+    using namespace juce;
+
+    g.fillAll(Colour(18u, 18u, 18u));
+
+    auto bounds = getLocalBounds().reduced(4, 0).withTrimmedTop(10).toFloat();
+
+    auto formatLoudness = [](const String &name, float lufs)
+    {
+        return name + (lufs > MeterReadings::floorDecibels ? String(lufs, 1) : String("-inf"));
+    };
+
+    g.setColour(Colours::white);
+    g.setFont(11);
+    g.drawFittedText(formatLoudness("S ", shortTermLoudness), bounds.removeFromBottom(13).toNearestInt(), Justification::centred, 1);
+    g.drawFittedText(formatLoudness("M ", momentaryLoudness), bounds.removeFromBottom(13).toNearestInt(), Justification::centred, 1);
+
+    auto barWidth = (bounds.getWidth() - 4.0f) / 2.0f;
+    drawBar(g, bounds.removeFromLeft(barWidth), input, "In");
+    drawBar(g, bounds.removeFromRight(barWidth), output, "Out");
+}
+
+FrameTimingOverlay::FrameTimingOverlay(FrameTimings &timings) : frameTimings(timings)
+{
+    setInterceptsMouseClicks(false, false);
+}
+
+void FrameTimingOverlay::visibilityChanged()
+{
+    if (isVisible())
+    {
+        timerCallback();
+        startTimerHz(refreshRateHz);
+    }
+    else
+    {
+        stopTimer();
+    }
+}
+
+void FrameTimingOverlay::timerCallback()
+{
+    for (int stage = 0; stage < FrameTimings::numStages; stage++)
+        summaries[(size_t)stage] = frameTimings[(FrameTimings::Stage)stage].getSummary();
+
+    repaint();
+}
+
+void FrameTimingOverlay::paint(juce::Graphics &g)
+{
+    using namespace juce;
+
+    g.fillAll(Colours::black.withAlpha(0.8f));
+
+    auto bounds = getLocalBounds().reduced(8);
+
+    g.setFont(12);
+    g.setColour(Colours::white);
+    g.drawText("Frame times over the last " + String(FrameTimeHistogram::windowSize) + " runs, ms (median / 95% / max)",
+               bounds.removeFromTop(16), Justification::centredLeft, false);
+
+    // One row per stage: name, histogram with 0.125 ms to 32 ms buckets, then the figures
+    auto rowHeight = jmin(24, bounds.getHeight() / FrameTimings::numStages);
+
+    for (int stage = 0; stage < FrameTimings::numStages; stage++)
+    {
+        const auto &summary = summaries[(size_t)stage];
+        auto row = bounds.removeFromTop(rowHeight);
+
+        g.setColour(FrameTimings::isOnMessageThread((FrameTimings::Stage)stage) ? Colours::white : Colours::grey);
+        g.drawText(FrameTimings::getStageName((FrameTimings::Stage)stage), row.removeFromLeft(150), Justification::centredLeft, false);
+
+        g.drawText(String(summary.median, 2) + " / " + String(summary.percentile95, 2) + " / " + String(summary.max, 2),
+                   row.removeFromRight(140), Justification::centredRight, false);
+
+        auto histogram = row.reduced(4, 3).toFloat();
+        auto barWidth = histogram.getWidth() / FrameTimeHistogram::numBuckets;
+
+        for (int bucket = 0; bucket < FrameTimeHistogram::numBuckets; bucket++)
+        {
+            auto bar = histogram.removeFromLeft(barWidth).reduced(1.0f, 0.0f);
+            auto proportion = summary.numRuns > 0 ? (float)summary.counts[(size_t)bucket] / (float)summary.numRuns : 0.0f;
+
+            g.setColour(Colour(33u, 33u, 33u));
+            g.fillRect(bar);
+
+            // Buckets at or past the 16 ms frame budget in red
+            g.setColour(FrameTimeHistogram::getBucketLimit(bucket) > 16.0 ? Colours::red : Colour(3u, 218u, 197u));
+            g.fillRect(bar.withTop(bar.getBottom() - bar.getHeight() * proportion));
+        }
+    }
+}
+
 AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor(AudioPluginAudioProcessor &p) : AudioProcessorEditor(&p), processorRef(p),
 
                                                                                                  peakFreqSlider(*processorRef.apvts.getParameter("Peak Freq"), "Hz"),
@@ -435,6 +597,8 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor(AudioPluginAudi
                                                                                                  highCutSlopeSlider(*processorRef.apvts.getParameter("High Cut Slope"), "dB/oct"),
 
                                                                                                  responseCurveComponent(processorRef),
+                                                                                                 levelMeterComponent(processorRef.getMeterReadings()),
+                                                                                                 frameTimingOverlay(processorRef.getAnalysisEngine().getFrameTimings()),
                                                                                                  peakFreqSliderAttachment(processorRef.apvts, "Peak Freq", peakFreqSlider),
                                                                                                  peakGainSliderAttachment(processorRef.apvts, "Peak Gain", peakGainSlider),
                                                                                                  peakQualitySliderAttachment(processorRef.apvts, "Peak Quality", peakQualitySlider),
@@ -477,9 +641,21 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor(AudioPluginAudi
         addAndMakeVisible(comp);
     }
 
-    peakBypassButton.setLookAndFeel(&lnf);
-    lowCutBypassButton.setLookAndFeel(&lnf);
-    HighCutBypassButton.setLookAndFeel(&lnf);
+    auto &frameTimings = processorRef.getAnalysisEngine().getFrameTimings();
+
+    for (auto *slider : {&peakFreqSlider, &peakGainSlider, &peakQualitySlider, &lowCutFreqSlider, &highCutFreqSlider,
+                         &lowCutSlopeSlider, &highCutSlopeSlider})
+    {
+        slider->paintTimes = &frameTimings[FrameTimings::sliderPaint];
+    }
+
+    // Hidden until asked for, on top of everything else
+    addChildComponent(frameTimingOverlay);
+    setWantsKeyboardFocus(true);
+
+    peakBypassButton.setLookAndFeel(&lnf.get());
+    lowCutBypassButton.setLookAndFeel(&lnf.get());
+    HighCutBypassButton.setLookAndFeel(&lnf.get());
 
     setSize(600, 480);
 }
@@ -491,8 +667,14 @@ AudioPluginAudioProcessorEditor::~AudioPluginAudioProcessorEditor()
     HighCutBypassButton.setLookAndFeel(nullptr);
 }
 
+size_t AudioPluginAudioProcessorEditor::getMemoryUsage() const
+{
+    return sizeof(*this) - sizeof(responseCurveComponent) + responseCurveComponent.getMemoryUsage();
+}
+
 void AudioPluginAudioProcessorEditor::paint(juce::Graphics &g)
 {
+    EQ_TRACE_SCOPE("Editor::paint");
     using namespace juce;
 
     // (Our component is opaque, so we must completely fill the background with a solid colour)
@@ -508,6 +690,30 @@ void AudioPluginAudioProcessorEditor::paint(juce::Graphics &g)
     g.drawFittedText("High Cut", highCutSlopeSlider.getBounds(), juce::Justification::centredBottom, 1);
 }
 
+bool AudioPluginAudioProcessorEditor::keyPressed(const juce::KeyPress &key)
+{
+    auto modifiers = juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier;
+
+    if (key == juce::KeyPress('f', modifiers, 0))
+    {
+        setFrameTimingOverlayVisible(!isFrameTimingOverlayVisible());
+        return true;
+    }
+
+    if (key == juce::KeyPress('s', modifiers, 0))
+    {
+        setSpectrogramMode(!isSpectrogramMode());
+        return true;
+    }
+
+    return false;
+}
+
+void AudioPluginAudioProcessorEditor::setFrameTimingOverlayVisible(bool shouldBeVisible)
+{
+    frameTimingOverlay.setVisible(shouldBeVisible);
+}
+
 void AudioPluginAudioProcessorEditor::resized()
 {
     // This is generally where you'll want to lay out the positions of any
@@ -515,9 +721,12 @@ void AudioPluginAudioProcessorEditor::resized()
 
     auto bounds = getLocalBounds();
 
+    frameTimingOverlay.setBounds(bounds.reduced(20));
+
     float hRatio = 25.0f / 100.0f;
     auto responseArea = bounds.removeFromTop(bounds.getHeight() * hRatio);
 
+    levelMeterComponent.setBounds(responseArea.removeFromRight(70));
     responseCurveComponent.setBounds(responseArea);
 
     bounds.removeFromTop(5);
@@ -543,6 +752,6 @@ void AudioPluginAudioProcessorEditor::resized()
 std::vector<juce::Component *> AudioPluginAudioProcessorEditor::getComps()
 {
     return {&peakFreqSlider, &peakGainSlider, &peakQualitySlider,
-            &lowCutFreqSlider, &highCutFreqSlider, &lowCutSlopeSlider, &highCutSlopeSlider, &responseCurveComponent,
+            &lowCutFreqSlider, &highCutFreqSlider, &lowCutSlopeSlider, &highCutSlopeSlider, &responseCurveComponent, &levelMeterComponent,
             &lowCutBypassButton, &peakBypassButton, &HighCutBypassButton};
 }
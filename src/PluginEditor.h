@@ -1,105 +1,29 @@
 #pragma once
 
 #include "PluginProcessor.h"
-
-enum FFTOrder
-{
-    order2048 = 11,
-    order4096 = 12,
-    order8192 = 13
-};
-
-template <typename BlockType>
-struct FFTDataGenerator
-{
-    // Produces the FFT data from an audio buffer
-    void produceFFTDataForRendering(const juce::AudioBuffer<float> &audioData, const float negativeInfinity)
-    {
-        const auto fftSize = getFFTSize();
-
-        fftData.assign(fftData.size(), 0);
-        auto *readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
-
-        // First apply a windowing function to our data
-        window->multiplyWithWindowingTable(fftData.data(), fftSize); // [1]
-
-        // Then render our FFT data
-        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data()); // [2]
-
-        int numBins = (int)fftSize / 2;
-
-        // Normalize the fft values
-        for (int i = 0; i < numBins; ++i)
-        {
-            auto v = fftData[i];
-
-            if (!std::isinf(v) && !std::isnan(v))
-            {
-                v /= float(numBins);
-            }
-            else
-            {
-                v = 0.f;
-            }
-
-            fftData[i] = v;
-        }
-
-        // Convert them to decibels
-        for (int i = 0; i < numBins; i++)
-        {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
-        }
-
-        fftDataFifo.push(fftData);
-    }
-
-    void changeOrder(FFTOrder newOrder)
-    {
-        // When you change order, recreate the window, forwardFFT, fifo, fftData
-        // Also reset the fifoIndex
-        // Things that need recreating should be created on the heap via std::make_unique<>
-
-        order = newOrder;
-        auto fftSize = getFFTSize();
-
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize,
-                                                                       juce::dsp::WindowingFunction<float>::blackmanHarris);
-
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
-
-        fftDataFifo.prepare(fftData.size());
-    }
-    int getFFTSize() const { return 1 << order; }
-    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
-
-    bool getFFTData(BlockType &fftData) { return fftDataFifo.pull(fftData); }
-
-private:
-    FFTOrder order;
-    BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
-    Fifo<BlockType> fftDataFifo;
-};
+#include "AnalysisEngine.h"
+#include "SpectrogramImage.h"
 
 template <typename PathType>
 struct AnalyzerPathGenerator
 {
     // Converts 'renderData[]' into a juce::Path
+    // Draws a line-to every 'pathResolution' bins, and no closer than 'minPointSpacing' pixels
+    // to the previous one, which only a smoothed spectrum can afford
     void generatePath(const std::vector<float> &renderData, juce::Rectangle<float> fftBounds, int fftSize,
-                      float binWidth, float negativeInfinity)
+                      float binWidth, float negativeInfinity, int pathResolution, float minPointSpacing = 0.0f)
     {
+        EQ_TRACE_SCOPE("generatePath");
+
         auto top = fftBounds.getY();
         auto bottom = fftBounds.getHeight();
         auto width = fftBounds.getWidth();
 
         int numBins = (int)fftSize / 2;
 
-        PathType p;
+        // Reuses the storage of a path that has already been drawn
+        auto &p = paths.getWriteBuffer();
+        p.clear();
         p.preallocateSpace(3 * (int)fftBounds.getWidth());
 
         auto map = [bottom, top, negativeInfinity](float v)
@@ -116,7 +40,7 @@ struct AnalyzerPathGenerator
 
         p.startNewSubPath(0, y);
 
-        const int pathResolution = 2; // You can draw line-to's every 'pathResolution' pixels
+        auto lastX = -minPointSpacing;
 
         for (int binNum = 1; binNum < numBins; binNum += pathResolution)
         {
@@ -127,25 +51,35 @@ struct AnalyzerPathGenerator
                 auto binFreq = binNum * binWidth;
                 auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
                 int binX = std::floor(normalizedBinX * width);
+
+                if (binX < lastX + minPointSpacing)
+                    continue;
+
                 p.lineTo(binX, y);
+                lastX = (float)binX;
             }
         }
 
-        pathFifo.push(p);
+        paths.publish();
     }
 
-    int getNumPathsAvailable() const
+    // Swaps the newest path into 'path', if one has been generated since the last call
+    bool getPath(PathType &path)
     {
-        return pathFifo.getNumAvailableForReading();
+        if (!paths.acquire())
+            return false;
+
+        std::swap(path, paths.getReadBuffer());
+        return true;
     }
 
-    bool getPath(PathType &path)
+    size_t getMemoryUsage() const
     {
-        return pathFifo.pull(path);
+        return sizeof(paths);
     }
 
 private:
-    Fifo<PathType> pathFifo;
+    LatestFrame<PathType> paths;
 };
 
 struct LookAndFeel : juce::LookAndFeel_V4
@@ -163,7 +97,7 @@ struct RotarySliderWithLabels : juce::Slider
                                                                                                            juce::Slider::TextEntryBoxPosition::NoTextBox),
                                                                                               param(&rap), suffix(unitSuffix)
     {
-        setLookAndFeel(&lnf);
+        setLookAndFeel(&lnf.get());
     }
 
     ~RotarySliderWithLabels()
@@ -179,6 +113,9 @@ struct RotarySliderWithLabels : juce::Slider
 
     juce::Array<LabelPos> labels;
 
+    // Where paint() records how long it took, if anywhere
+    FrameTimeHistogram *paintTimes = nullptr;
+
     void paint(juce::Graphics &g) override;
     int getTextHeight() const { return 14; }
 
@@ -186,37 +123,132 @@ struct RotarySliderWithLabels : juce::Slider
     juce::String getDisplayString() const;
 
 private:
-    LookAndFeel lnf;
+    // The look and feel is stateless, so every slider in the process shares one
+    juce::SharedResourcePointer<LookAndFeel> lnf;
 
     juce::RangedAudioParameter *param;
     juce::String suffix;
 };
 
-struct ResponseCurveComponent : juce::Component, juce::AudioProcessorParameter::Listener, juce::Timer
+// Turns the engine's spectrum into a path on the analyzer worker pool, so the message thread
+// only has to draw it. The path depends on the size of the view, which the editor hands over
+// with setRenderBounds().
+class AnalyzerPathJob : private AnalyzerWorkerPool::Client
+{
+public:
+    explicit AnalyzerPathJob(AnalysisEngine &engine);
+    ~AnalyzerPathJob() override;
+
+    // Call from the message thread
+    void setRenderBounds(juce::Rectangle<float> bounds);
+
+    // Swaps the newest path into 'path', if one has been built since the last call
+    bool getPath(juce::Path &path) { return pathProducer.getPath(path); }
+
+    size_t getMemoryUsage() const { return sizeof(*this) + pathProducer.getMemoryUsage(); }
+
+private:
+    AnalysisEngine &engineRef;
+    juce::SharedResourcePointer<AnalyzerWorkerPool> workerPool;
+
+    juce::SpinLock boundsLock;
+    juce::Rectangle<float> renderBounds;
+
+    // Only touched on the worker
+    juce::Rectangle<float> lastBounds;
+    juce::uint64 lastSpectrumIndex = 0;
+    int lastQualityLevel = 0;
+    AnalyzerPathGenerator<juce::Path> pathProducer;
+
+    void runAnalysisFrame() override;
+
+    JUCE_DECLARE_NON_COPYABLE(AnalyzerPathJob)
+};
+
+// Draws the processor's latest analysis snapshot. All the analysis itself happens on the
+// analyzer worker pool, so any number of these can be open at little extra cost.
+//
+// In spectrogram mode the response curve and analyzer path give way to a scrolling
+// time-frequency view of the spectrum, built up a column per analyzer frame.
+struct ResponseCurveComponent : juce::Component, juce::Timer
 {
     ResponseCurveComponent(AudioPluginAudioProcessor &);
-    ~ResponseCurveComponent();
 
-    void parameterValueChanged(int parameterIndex, float newValue) override;
-    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override {};
     void timerCallback() override;
     void paint(juce::Graphics &g) override;
     void resized() override;
+    void mouseDoubleClick(const juce::MouseEvent &) override;
+
+    // Also toggled by double-clicking. Entering the mode starts the history afresh.
+    void setSpectrogramMode(bool shouldShowSpectrogram);
+    bool isSpectrogramMode() const { return spectrogramMode; }
+
+    size_t getMemoryUsage() const;
 
 private:
     AudioPluginAudioProcessor &processorRef;
 
-    juce::Atomic<bool> parametersChanged{false};
     juce::Image background;
     juce::Rectangle<int> getRenderArea();
-    juce::AudioBuffer<float> monoBuffer;
     juce::Path leftChannelFFTPath;
 
-    MonoChain monoChain;
-    void updateChain();
-    SingleChannelSampleFifo<AudioPluginAudioProcessor::BlockType> *leftChannelFifo;
-    FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
-    AnalyzerPathGenerator<juce::Path> pathProducer;
+    std::shared_ptr<const AnalysisSnapshot> snapshot;
+    AnalyzerPathJob pathJob;
+
+    // The timer follows the analyzer's frame rate, which drops with its quality level
+    int timerQualityLevel = 0;
+
+    // Reported to the governor with each timer callback
+    double lastPaintMilliseconds = 0.0;
+
+    bool spectrogramMode = false;
+    SpectrogramImage spectrogram;
+    juce::uint64 lastSpectrogramIndex = 0;
+};
+
+// Input and output level bars, RMS filled and peak as a falling line, with the output's
+// loudness underneath
+struct LevelMeterComponent : juce::Component, juce::Timer
+{
+    LevelMeterComponent(MeterReadings &readings);
+
+    void timerCallback() override;
+    void paint(juce::Graphics &g) override;
+
+private:
+    static constexpr float minDecibels = -60.0f;
+    static constexpr float peakFallPerSecond = 20.0f;
+    static constexpr int refreshRateHz = 30;
+
+    struct Bar
+    {
+        float rmsDecibels{minDecibels};
+        float peakDecibels{minDecibels};
+    };
+
+    MeterReadings &meterReadings;
+    Bar input, output;
+    float momentaryLoudness{MeterReadings::floorDecibels}, shortTermLoudness{MeterReadings::floorDecibels};
+
+    static void updateBar(Bar &bar, MeterReadings::Tap &tap);
+    static void drawBar(juce::Graphics &g, juce::Rectangle<float> bounds, const Bar &bar, const juce::String &label);
+};
+
+// Debug overlay with a histogram and percentiles for each FrameTimings stage. Refreshes itself
+// a few times a second while visible, and lets mouse clicks through to the editor underneath.
+struct FrameTimingOverlay : juce::Component, juce::Timer
+{
+    FrameTimingOverlay(FrameTimings &timings);
+
+    void timerCallback() override;
+    void paint(juce::Graphics &g) override;
+    void visibilityChanged() override;
+
+private:
+    static constexpr int refreshRateHz = 4;
+
+    FrameTimings &frameTimings;
+    std::array<FrameTimeHistogram::Summary, FrameTimings::numStages> summaries;
 };
 
 class AudioPluginAudioProcessorEditor : public juce::AudioProcessorEditor
@@ -227,6 +259,18 @@ public:
 
     void paint(juce::Graphics &) override;
     void resized() override;
+    bool keyPressed(const juce::KeyPress &key) override;
+
+    size_t getMemoryUsage() const;
+
+    // The frame timing overlay, also toggled with Ctrl+Shift+F (Cmd+Shift+F on macOS)
+    void setFrameTimingOverlayVisible(bool shouldBeVisible);
+    bool isFrameTimingOverlayVisible() const { return frameTimingOverlay.isVisible(); }
+
+    // Spectrogram in place of the response curve, also toggled with Ctrl+Shift+S (Cmd+Shift+S
+    // on macOS) or by double-clicking the curve
+    void setSpectrogramMode(bool shouldShowSpectrogram) { responseCurveComponent.setSpectrogramMode(shouldShowSpectrogram); }
+    bool isSpectrogramMode() const { return responseCurveComponent.isSpectrogramMode(); }
 
 private:
     // This reference is provided as a quick way for your editor to
@@ -237,6 +281,8 @@ private:
         lowCutSlopeSlider, highCutSlopeSlider;
 
     ResponseCurveComponent responseCurveComponent;
+    LevelMeterComponent levelMeterComponent;
+    FrameTimingOverlay frameTimingOverlay;
 
     using APVTS = juce::AudioProcessorValueTreeState;
     using Attachment = APVTS::SliderAttachment;
@@ -251,7 +297,7 @@ private:
 
     std::vector<juce::Component *> getComps();
 
-    LookAndFeel lnf;
+    juce::SharedResourcePointer<LookAndFeel> lnf;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioPluginAudioProcessorEditor)
 };
@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "AnalysisEngine.h"
 
 AudioPluginAudioProcessor::AudioPluginAudioProcessor()
     : AudioProcessor(BusesProperties()
@@ -11,10 +12,37 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
 #endif
       )
 {
+    // Does the CPU check now, rather than on the audio thread
+    Kernels::getTable();
+
+    analysisEngine = std::make_unique<AnalysisEngine>(*this);
+    analysisEngine->start();
+
+    auto traceDirectory = juce::SystemStats::getEnvironmentVariable("EQUALIZER_AUTOMATION_TRACE", {}).trim();
+
+    if (traceDirectory.isNotEmpty())
+        startAutomationTrace(juce::File(traceDirectory).getNonexistentChildFile("EqualizerAutomation", ".eqtrace"));
+
+    // Any value but 0 turns the shared-memory export on, for tools/MonitorReader.cpp
+    auto sharedMonitor = juce::SystemStats::getEnvironmentVariable("EQUALIZER_SHARED_MONITOR", {}).trim();
+
+    if (sharedMonitor.isNotEmpty() && sharedMonitor != "0")
+    {
+        if (analysisEngine->setSharedMemoryExportEnabled(true))
+            DBG("Shared monitor: " << analysisEngine->getSharedMemoryName());
+    }
+
+    // Likewise for the coefficient bank, which is built on the first prepareToPlay
+    auto coefficientBank = juce::SystemStats::getEnvironmentVariable("EQUALIZER_COEFFICIENT_BANK", {}).trim();
+
+    if (coefficientBank.isNotEmpty() && coefficientBank != "0")
+        setCoefficientBankEnabled(true);
 }
 
 AudioPluginAudioProcessor::~AudioPluginAudioProcessor()
 {
+    // Stops the analysis thread before the FIFOs it reads from go away
+    analysisEngine.reset();
 }
 
 const juce::String AudioPluginAudioProcessor::getName() const
@@ -51,7 +79,7 @@ bool AudioPluginAudioProcessor::isMidiEffect() const
 
 double AudioPluginAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.load();
 }
 
 int AudioPluginAudioProcessor::getNumPrograms()
@@ -92,13 +120,44 @@ void AudioPluginAudioProcessor::prepareToPlay(double sampleRate, int samplesPerB
     spec.numChannels = 1;
     spec.sampleRate = sampleRate;
 
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    auto numChannels = juce::jmax(1, getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+    // Both precisions are cheap to prepare, and the host may switch between them
+    prepareChain<float>(spec, numChannels);
+    prepareChain<double>(spec, numChannels);
+
+    numSilentSamples = 0.0;
+    chainIsFlushed = false;
+
+    floatCoefficientBank.reset();
+    doubleCoefficientBank.reset();
+
+    if (isCoefficientBankEnabled())
+    {
+        if (isUsingDoublePrecision())
+            doubleCoefficientBank = coefficientBankCache->getBank<double>(sampleRate);
+        else
+            floatCoefficientBank = coefficientBankCache->getBank<float>(sampleRate);
+    }
 
     updateFilters();
 
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    // The editor pulls from the analyzer FIFOs at 60 Hz, so only keep about two frames worth of blocks
+    auto blocksPerFrame = (int)std::ceil(sampleRate / (60.0 * juce::jmax(1, samplesPerBlock)));
+    auto numBuffers = juce::jlimit(2, 30, 2 * blocksPerFrame);
+
+    {
+        // The analysis worker could be halfway through draining them otherwise
+        const juce::ScopedLock sl(analyzerFifoLock);
+
+        leftChannelFifo.prepare(samplesPerBlock, numBuffers);
+        rightChannelFifo.prepare(samplesPerBlock, numBuffers);
+        analysisSampleRate = sampleRate;
+    }
+
+    loadMeasurer.reset(sampleRate, samplesPerBlock);
+
+    automationTrace.recordPrepare(sampleRate, samplesPerBlock, numChannels, isUsingDoublePrecision());
 }
 
 void AudioPluginAudioProcessor::releaseResources()
@@ -114,10 +173,10 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported(const BusesLayout &layout
     return true;
 #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
+    // Every channel runs its own copy of the chain, so any layout will do.
     // Some plugin hosts, such as certain GarageBand versions, will only
     // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono() && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
         // This checks if the input layout matches the output layout
@@ -134,7 +193,257 @@ void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
                                              juce::MidiBuffer &midiMessages)
 {
     juce::ignoreUnused(midiMessages);
+    process(buffer);
+}
+
+void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<double> &buffer,
+                                             juce::MidiBuffer &midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    process(buffer);
+}
+
+bool AudioPluginAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+void AudioPluginAudioProcessor::setMultithreadedRenderingEnabled(bool shouldBeEnabled)
+{
+    multithreadedRenderingEnabled.store(shouldBeEnabled);
+}
+
+bool AudioPluginAudioProcessor::isMultithreadedRenderingEnabled() const
+{
+    return multithreadedRenderingEnabled.load();
+}
+
+void AudioPluginAudioProcessor::setCoefficientBankEnabled(bool shouldBeEnabled)
+{
+    coefficientBankEnabled.store(shouldBeEnabled);
+}
+
+bool AudioPluginAudioProcessor::isCoefficientBankEnabled() const
+{
+    return coefficientBankEnabled.load();
+}
+
+double AudioPluginAudioProcessor::getAudioLoad() const
+{
+    // Offline renders run as fast as they can, so their load says nothing about headroom
+    return isNonRealtime() ? 0.0 : loadMeasurer.getLoadAsProportion();
+}
+
+int AudioPluginAudioProcessor::getNumAudioOverruns() const
+{
+    return isNonRealtime() ? 0 : loadMeasurer.getXRunCount();
+}
+
+bool AudioPluginAudioProcessor::startAutomationTrace(const juce::File &file)
+{
+    return automationTrace.start(file);
+}
+
+void AudioPluginAudioProcessor::stopAutomationTrace()
+{
+    automationTrace.stop();
+}
+
+bool AudioPluginAudioProcessor::isRecordingAutomationTrace() const
+{
+    return automationTrace.isRecording();
+}
+
+double AudioPluginAudioProcessor::getCoefficientBankBuildTimeSeconds() const
+{
+    if (floatCoefficientBank != nullptr)
+        return floatCoefficientBank->getBuildTimeSeconds();
+    if (doubleCoefficientBank != nullptr)
+        return doubleCoefficientBank->getBuildTimeSeconds();
+
+    return 0.0;
+}
+
+template <typename SampleType>
+Kernels::BiquadSection<SampleType> makeKernelSection(const Filter<SampleType> &filter, SampleType *state)
+{
+    auto *c = filter.coefficients->getRawCoefficients();
+    return {c[0], c[1], c[2], c[3], c[4], state};
+}
+
+// The first 'numSections' sections of a cut, each with its own slot in 'state'
+template <int numSections, typename SampleType>
+void getKernelSections(const CutFilter<SampleType> &cut, SampleType *state, Kernels::BiquadSection<SampleType> *sections)
+{
+    if constexpr (numSections > 0)
+        sections[0] = makeKernelSection(cut.template get<0>(), state);
+    if constexpr (numSections > 1)
+        sections[1] = makeKernelSection(cut.template get<1>(), state + 2);
+    if constexpr (numSections > 2)
+        sections[2] = makeKernelSection(cut.template get<2>(), state + 4);
+    if constexpr (numSections > 3)
+        sections[3] = makeKernelSection(cut.template get<3>(), state + 6);
+}
 
+// Same as MonoChain::process(), through the dispatched kernel, for one shape of the chain:
+// how many sections each cut has running (none when it's bypassed) and whether the peak is
+// in. That's all known at compile time, so every active section goes through in one pass
+// with nothing checked per block or per sample, except in tracing builds, which run the
+// stages one at a time to time them separately. Bypassed sections keep their state, as they
+// do in the chain.
+template <typename SampleType, int numLowCutSections, bool peakIsActive, int numHighCutSections>
+void processCascadeVariant(const MonoChain<SampleType> &chain, SampleType *samples, int numSamples, SampleType *state)
+{
+    constexpr int numPeakSections = peakIsActive ? 1 : 0;
+    constexpr int numSections = numLowCutSections + numPeakSections + numHighCutSections;
+
+    static_assert(numSections <= Kernels::maxFixedSections);
+
+    std::array<Kernels::BiquadSection<SampleType>, (size_t)numSections> sections;
+
+    auto *peakState = state + 2 * Butterworth::maxSections;
+    auto *highCutState = peakState + 2;
+
+    getKernelSections<numLowCutSections>(chain.template get<ChainPositions::LowCut>(), state, sections.data());
+
+    if constexpr (peakIsActive)
+        sections[numLowCutSections] = makeKernelSection(chain.template get<ChainPositions::Peak>(), peakState);
+
+    getKernelSections<numHighCutSections>(chain.template get<ChainPositions::HighCut>(), highCutState,
+                                          sections.data() + numLowCutSections + numPeakSections);
+
+    if constexpr (Tracing::isCompiledIn())
+    {
+        // A pass per stage, a bit slower than the single pass, so each stage gets its own
+        // event on the timeline
+        if constexpr (numLowCutSections > 0)
+        {
+            EQ_TRACE_SCOPE("Low cut");
+            Kernels::processCascadeFixed<numLowCutSections>(samples, numSamples, sections.data());
+        }
+
+        if constexpr (peakIsActive)
+        {
+            EQ_TRACE_SCOPE("Peak");
+            Kernels::processCascadeFixed<1>(samples, numSamples, sections.data() + numLowCutSections);
+        }
+
+        if constexpr (numHighCutSections > 0)
+        {
+            EQ_TRACE_SCOPE("High cut");
+            Kernels::processCascadeFixed<numHighCutSections>(samples, numSamples,
+                                                             sections.data() + numLowCutSections + numPeakSections);
+        }
+    }
+    else
+    {
+        Kernels::processCascadeFixed<numSections>(samples, numSamples, sections.data());
+    }
+}
+
+// One variant for each combination of the two slopes and the three stages' bypass, indexed
+// as [low cut slope][high cut slope][mask] with the mask's bits for the low cut, peak and
+// high cut being active. Bypassed cuts make their slope irrelevant, so several entries share
+// a function.
+constexpr int numCascadeVariants = 4 * 4 * 8;
+
+template <typename SampleType, int index>
+constexpr CascadeVariant<SampleType> makeCascadeVariant()
+{
+    constexpr int lowCutSlope = index / 32;
+    constexpr int highCutSlope = (index / 8) % 4;
+    constexpr int mask = index % 8;
+
+    return processCascadeVariant<SampleType, (mask & 1) != 0 ? lowCutSlope + 1 : 0, (mask & 2) != 0,
+                                 (mask & 4) != 0 ? highCutSlope + 1 : 0>;
+}
+
+template <typename SampleType, int... indices>
+constexpr std::array<CascadeVariant<SampleType>, sizeof...(indices)>
+makeCascadeVariants(std::integer_sequence<int, indices...>)
+{
+    return {makeCascadeVariant<SampleType, indices>()...};
+}
+
+template <typename SampleType>
+CascadeVariant<SampleType> selectCascadeVariant(const ChainSettings &chainSettings)
+{
+    static constexpr auto variants = makeCascadeVariants<SampleType>(std::make_integer_sequence<int, numCascadeVariants>());
+
+    auto lowCutSlope = juce::jlimit(0, 3, (int)chainSettings.lowCutSlope);
+    auto highCutSlope = juce::jlimit(0, 3, (int)chainSettings.highCutSlope);
+
+    // Matches the bypass updateFilters() gives the chain
+    auto mask = (chainSettings.lowCutBypassed ? 0 : 1) |
+                (chainSettings.peakBypassed || isPeakNeutral(chainSettings) ? 0 : 2) |
+                (chainSettings.highCutBypassed ? 0 : 4);
+
+    return variants[(size_t)((lowCutSlope * 4 + highCutSlope) * 8 + mask)];
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::prepareChain(const juce::dsp::ProcessSpec &spec, int numChannels)
+{
+    auto &chain = getChain<SampleType>();
+
+    chain = MultiChannelChain<SampleType>((size_t)numChannels);
+    prepareCoefficients(chain.front());
+
+    for (auto &monoChain : chain)
+    {
+        monoChain.prepare(spec);
+        shareCoefficients(monoChain, chain.front());
+    }
+
+    getCascadeStates<SampleType>().assign((size_t)numChannels, {});
+    getCascadeVariant<SampleType>() = selectCascadeVariant<SampleType>(lastChainSettings);
+
+    getStateVariableEngine<SampleType>().prepare(spec.sampleRate, (int)spec.maximumBlockSize, numChannels);
+
+    // Loudness is only measured on the output
+    getMeters<SampleType>().input.prepare(spec.sampleRate, numChannels, false);
+    getMeters<SampleType>().output.prepare(spec.sampleRate, numChannels, true);
+}
+
+template <typename SampleType>
+static bool isSilent(const juce::AudioBuffer<SampleType> &buffer, int numChannels, SampleType threshold)
+{
+    numChannels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        auto range = buffer.findMinMax(channel, 0, buffer.getNumSamples());
+
+        if (-range.getStart() > threshold || range.getEnd() > threshold)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::resetCascade()
+{
+    for (auto &monoChain : getChain<SampleType>())
+    {
+        monoChain.reset();
+    }
+
+    for (auto &state : getCascadeStates<SampleType>())
+    {
+        state.fill(0);
+    }
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::process(juce::AudioBuffer<SampleType> &buffer)
+{
+    // Offline renders may lock to hand channels to the thread pool, everything else must not
+    RealtimeGuard::ScopedRealtimeSection realtimeSection(!isNonRealtime());
+    juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(loadMeasurer, buffer.getNumSamples());
+    EQ_TRACE_SCOPE("processBlock");
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -148,19 +457,95 @@ void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    updateFilters();
+    auto &meters = getMeters<SampleType>();
 
-    juce::dsp::AudioBlock<float> block(buffer);
+    {
+        EQ_TRACE_SCOPE("Input meter");
+        meters.input.process(buffer, meterReadings.input, nullptr);
+    }
+
+    automationTrace.recordBlock(buffer.getNumSamples());
 
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    auto chainSettings = getChainSettings(apvts);
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    if (chainSettings != lastChainSettings)
+    {
+        updateFilters<SampleType>(chainSettings);
+    }
+
+    auto &chain = getChain<SampleType>();
+
+    // Once the input has been silent for longer than the tail, the output is silent too,
+    // so the cascade can be skipped until the input comes back
+    auto silenceThreshold = (SampleType)juce::Decibels::decibelsToGain(silenceThresholdInDecibels);
+    auto inputIsSilent = isSilent(buffer, totalNumInputChannels, silenceThreshold);
+
+    // A neutral chain passes audio straight through
+    if (chainIsNeutral || (inputIsSilent && numSilentSamples >= tailLengthInSamples))
+    {
+        if (!chainIsFlushed)
+        {
+            // Clear whatever is left in the filter state, so it can't crawl into denormals
+            resetCascade<SampleType>();
+            getStateVariableEngine<SampleType>().reset();
+
+            chainIsFlushed = true;
+        }
+    }
+    else
+    {
+        juce::dsp::AudioBlock<SampleType> block(buffer);
+        auto numChannels = juce::jmin((int)chain.size(), (int)block.getNumChannels());
+        auto numSamples = (int)block.getNumSamples();
+
+        auto &stateVariableEngine = getStateVariableEngine<SampleType>();
+        auto useStateVariableEngine = chainSettings.engine == FilterEngine::StateVariable;
+
+        if (useStateVariableEngine)
+        {
+            stateVariableEngine.prepareBlock(numSamples);
+        }
+
+        auto &cascadeStates = getCascadeStates<SampleType>();
+        auto cascadeVariant = getCascadeVariant<SampleType>();
+
+        auto processChannel = [&chain, &cascadeStates, cascadeVariant, &block, &stateVariableEngine, useStateVariableEngine,
+                               numSamples](int channel)
+        {
+            auto *samples = block.getChannelPointer((size_t)channel);
+
+            if (useStateVariableEngine)
+            {
+                stateVariableEngine.processChannel(samples, channel, numSamples);
+                return;
+            }
+
+            cascadeVariant(chain[(size_t)channel], samples, numSamples, cascadeStates[(size_t)channel].data());
+        };
+
+        if (isNonRealtime() && isMultithreadedRenderingEnabled() && numChannels >= minChannelsForMultithreading)
+        {
+            channelThreadPool->parallelFor(numChannels, processChannel);
+        }
+        else
+        {
+            for (int channel = 0; channel < numChannels; channel++)
+            {
+                processChannel(channel);
+            }
+        }
+
+        chainIsFlushed = false;
+    }
 
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    numSilentSamples = inputIsSilent ? numSilentSamples + buffer.getNumSamples() : 0.0;
 
+    {
+        EQ_TRACE_SCOPE("Output meter");
+        meters.output.process(buffer, meterReadings.output, &meterReadings);
+    }
+
+    EQ_TRACE_SCOPE("Analyzer FIFOs");
     leftChannelFifo.update(buffer);
     rightChannelFifo.update(buffer);
 }
@@ -190,13 +575,20 @@ void AudioPluginAudioProcessor::setStateInformation(const void *data, int sizeIn
     // whose contents will have been created by the getStateInformation() call.
     auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
 
+    // The audio thread picks the new settings up on its next block
     if (tree.isValid())
     {
         apvts.replaceState(tree);
-        updateFilters();
     }
 }
 
+juce::StringArray getChainParameterIDs()
+{
+    return {"Low Cut Freq", "High Cut Freq", "Peak Freq", "Peak Gain", "Peak Quality", "Low Cut Slope",
+            "High Cut Slope", "Low Cut Bypassed", "Peak Bypassed", "High Cut Bypassed", "Filter Engine",
+            "Filter Design"};
+}
+
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState &apvts)
 {
     ChainSettings settings;
@@ -211,68 +603,410 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState &apvts)
     settings.lowCutBypassed = apvts.getRawParameterValue("Low Cut Bypassed")->load() > 0.5f;
     settings.peakBypassed = apvts.getRawParameterValue("Peak Bypassed")->load() > 0.5f;
     settings.highCutBypassed = apvts.getRawParameterValue("High Cut Bypassed")->load() > 0.5f;
+    settings.engine = static_cast<FilterEngine>(apvts.getRawParameterValue("Filter Engine")->load());
+    settings.design = static_cast<FilterDesign>(apvts.getRawParameterValue("Filter Design")->load());
 
     return settings;
 }
 
-Coefficients makePeakFilter(const ChainSettings &chainSettings, double sampleRate)
+bool isPeakNeutral(const ChainSettings &chainSettings)
+{
+    // "Peak Gain" is quantised to 0.1 dB steps, which leaves a little rounding error around 0
+    return std::abs(chainSettings.peakGainInDecibels) < 1.0e-4f;
+}
+
+bool isChainNeutral(const ChainSettings &chainSettings)
+{
+    return chainSettings.lowCutBypassed &&
+           (chainSettings.peakBypassed || isPeakNeutral(chainSettings)) &&
+           chainSettings.highCutBypassed;
+}
+
+FilterDesign getEffectiveDesign(const ChainSettings &chainSettings)
+{
+    return chainSettings.engine == FilterEngine::StateVariable ? FilterDesign::Bilinear : chainSettings.design;
+}
+
+bool operator==(const ChainSettings &lhs, const ChainSettings &rhs)
+{
+    return lhs.peakFreq == rhs.peakFreq &&
+           lhs.peakGainInDecibels == rhs.peakGainInDecibels &&
+           lhs.peakQuality == rhs.peakQuality &&
+           lhs.lowCutFreq == rhs.lowCutFreq &&
+           lhs.highCutFreq == rhs.highCutFreq &&
+           lhs.lowCutSlope == rhs.lowCutSlope &&
+           lhs.highCutSlope == rhs.highCutSlope &&
+           lhs.lowCutBypassed == rhs.lowCutBypassed &&
+           lhs.peakBypassed == rhs.peakBypassed &&
+           lhs.highCutBypassed == rhs.highCutBypassed &&
+           lhs.engine == rhs.engine &&
+           lhs.design == rhs.design;
+}
+
+bool operator!=(const ChainSettings &lhs, const ChainSettings &rhs)
 {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-                                                               chainSettings.peakFreq, chainSettings.peakQuality,
-                                                               juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+    return !(lhs == rhs);
 }
 
+template <typename SampleType>
 void AudioPluginAudioProcessor::updatePeakFilter(const ChainSettings &chainSettings)
 {
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
+    auto &chain = getChain<SampleType>();
+    auto peakIsExcluded = chainSettings.peakBypassed || isPeakNeutral(chainSettings);
+
+    for (auto &monoChain : chain)
+    {
+        monoChain.template setBypassed<ChainPositions::Peak>(peakIsExcluded);
+    }
+
+    if (peakIsExcluded)
+    {
+        return;
+    }
+
+    // Every channel shares the first channel's coefficient objects
+    auto &peak = chain.front().template get<ChainPositions::Peak>();
+
+    // The bank only holds bilinear designs
+    auto *bank = getEffectiveDesign(chainSettings) == FilterDesign::Bilinear ? getCoefficientBank<SampleType>() : nullptr;
+
+    if (bank != nullptr)
+    {
+        designPeakFilter(peak, chainSettings, bank->getPeakK(chainSettings.peakFreq), bank->getPeakA(chainSettings.peakGainInDecibels));
+    }
+    else
+    {
+        designPeakFilter(peak, chainSettings, getSampleRate());
+    }
+}
+
+template <typename ChainType>
+void shareCutCoefficients(ChainType &chain, const ChainType &source)
+{
+    chain.template get<0>().coefficients = source.template get<0>().coefficients;
+    chain.template get<1>().coefficients = source.template get<1>().coefficients;
+    chain.template get<2>().coefficients = source.template get<2>().coefficients;
+    chain.template get<3>().coefficients = source.template get<3>().coefficients;
+}
+
+template <typename SampleType>
+void shareCoefficients(MonoChain<SampleType> &chain, const MonoChain<SampleType> &source)
+{
+    shareCutCoefficients(chain.template get<ChainPositions::LowCut>(), source.template get<ChainPositions::LowCut>());
+    chain.template get<ChainPositions::Peak>().coefficients = source.template get<ChainPositions::Peak>().coefficients;
+    shareCutCoefficients(chain.template get<ChainPositions::HighCut>(), source.template get<ChainPositions::HighCut>());
+}
+
+template void shareCoefficients<float>(MonoChain<float> &, const MonoChain<float> &);
+template void shareCoefficients<double>(MonoChain<double> &, const MonoChain<double> &);
+
+template <typename SampleType>
+void prepareCutCoefficients(CutFilter<SampleType> &chain)
+{
+    const juce::dsp::IIR::Coefficients<SampleType> identity(1, 0, 0, 1, 0, 0);
+
+    *chain.template get<0>().coefficients = identity;
+    *chain.template get<1>().coefficients = identity;
+    *chain.template get<2>().coefficients = identity;
+    *chain.template get<3>().coefficients = identity;
+}
+
+template <typename SampleType>
+void prepareCoefficients(MonoChain<SampleType> &chain)
+{
+    prepareCutCoefficients(chain.template get<ChainPositions::LowCut>());
+    *chain.template get<ChainPositions::Peak>().coefficients = juce::dsp::IIR::Coefficients<SampleType>(1, 0, 0, 1, 0, 0);
+    prepareCutCoefficients(chain.template get<ChainPositions::HighCut>());
+}
 
-    leftChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    rightChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+template void prepareCoefficients<float>(MonoChain<float> &);
+template void prepareCoefficients<double>(MonoChain<double> &);
 
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+template <typename SampleType>
+static size_t getCoefficientsMemoryUsage(const Coefficients<SampleType> &coefficients)
+{
+    return sizeof(*coefficients) + (size_t)coefficients->coefficients.size() * sizeof(SampleType);
 }
 
-void updateCoefficients(Coefficients &old, const Coefficients &replacements)
+template <typename ChainType>
+size_t getCutCoefficientsMemoryUsage(const ChainType &chain)
 {
-    *old = *replacements;
+    return getCoefficientsMemoryUsage(chain.template get<0>().coefficients) +
+           getCoefficientsMemoryUsage(chain.template get<1>().coefficients) +
+           getCoefficientsMemoryUsage(chain.template get<2>().coefficients) +
+           getCoefficientsMemoryUsage(chain.template get<3>().coefficients);
 }
 
+template <typename SampleType>
+size_t getCoefficientsMemoryUsage(const MonoChain<SampleType> &chain)
+{
+    return getCutCoefficientsMemoryUsage(chain.template get<ChainPositions::LowCut>()) +
+           getCoefficientsMemoryUsage(chain.template get<ChainPositions::Peak>().coefficients) +
+           getCutCoefficientsMemoryUsage(chain.template get<ChainPositions::HighCut>());
+}
+
+template size_t getCoefficientsMemoryUsage<float>(const MonoChain<float> &);
+template size_t getCoefficientsMemoryUsage<double>(const MonoChain<double> &);
+
+template <typename SampleType>
+static double getTailLengthInSamples(const Coefficients<SampleType> &coefficients, double attenuation)
+{
+    const auto &c = coefficients->coefficients;
+    double radius = 0.0;
+
+    // Coefficients are stored normalised as b0..bN, a1..aN
+    if (c.size() == 5)
+    {
+        auto a1 = (double)c[3];
+        auto a2 = (double)c[4];
+        auto discriminant = a1 * a1 - 4.0 * a2;
+
+        if (discriminant < 0.0)
+        {
+            radius = std::sqrt(a2);
+        }
+        else
+        {
+            auto root = std::sqrt(discriminant);
+            radius = 0.5 * juce::jmax(std::abs(-a1 + root), std::abs(-a1 - root));
+        }
+    }
+    else if (c.size() == 3)
+    {
+        radius = std::abs((double)c[2]);
+    }
+
+    // No poles, the section is done after its zeros have passed
+    if (radius <= 0.0)
+    {
+        return 2.0;
+    }
+
+    if (radius >= 1.0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    return std::log(attenuation) / std::log(radius) + 2.0;
+}
+
+template <typename ChainType>
+double getCutTailLengthInSamples(const ChainType &chain, double attenuation)
+{
+    double samples = 0.0;
+
+    if (!chain.template isBypassed<0>())
+        samples += getTailLengthInSamples(chain.template get<0>().coefficients, attenuation);
+    if (!chain.template isBypassed<1>())
+        samples += getTailLengthInSamples(chain.template get<1>().coefficients, attenuation);
+    if (!chain.template isBypassed<2>())
+        samples += getTailLengthInSamples(chain.template get<2>().coefficients, attenuation);
+    if (!chain.template isBypassed<3>())
+        samples += getTailLengthInSamples(chain.template get<3>().coefficients, attenuation);
+
+    return samples;
+}
+
+template <typename SampleType>
+double getTailLengthInSamples(const MonoChain<SampleType> &chain, double attenuationInDecibels)
+{
+    auto attenuation = juce::Decibels::decibelsToGain(attenuationInDecibels);
+    double samples = 0.0;
+
+    if (!chain.template isBypassed<ChainPositions::LowCut>())
+        samples += getCutTailLengthInSamples(chain.template get<ChainPositions::LowCut>(), attenuation);
+    if (!chain.template isBypassed<ChainPositions::Peak>())
+        samples += getTailLengthInSamples(chain.template get<ChainPositions::Peak>().coefficients, attenuation);
+    if (!chain.template isBypassed<ChainPositions::HighCut>())
+        samples += getCutTailLengthInSamples(chain.template get<ChainPositions::HighCut>(), attenuation);
+
+    return samples;
+}
+
+template double getTailLengthInSamples<float>(const MonoChain<float> &, double);
+template double getTailLengthInSamples<double>(const MonoChain<double> &, double);
+
+MemoryFootprint AudioPluginAudioProcessor::getMemoryFootprint() const
+{
+    MemoryFootprint footprint;
+
+    footprint.processor = sizeof(*this) +
+                          floatChain.capacity() * sizeof(MonoChain<float>) +
+                          doubleChain.capacity() * sizeof(MonoChain<double>) +
+                          floatCascadeStates.capacity() * sizeof(CascadeState<float>) +
+                          doubleCascadeStates.capacity() * sizeof(CascadeState<double>) +
+                          automationTrace.getMemoryUsage();
+
+    // All channels share their coefficient objects, so they only count once
+    if (!floatChain.empty())
+        footprint.filterCoefficients += getCoefficientsMemoryUsage(floatChain.front());
+    if (!doubleChain.empty())
+        footprint.filterCoefficients += getCoefficientsMemoryUsage(doubleChain.front());
+
+    if (floatCoefficientBank != nullptr)
+        footprint.coefficientBank += floatCoefficientBank->getMemoryUsage();
+    if (doubleCoefficientBank != nullptr)
+        footprint.coefficientBank += doubleCoefficientBank->getMemoryUsage();
+    footprint.analyzerFifos = leftChannelFifo.getMemoryUsage() + rightChannelFifo.getMemoryUsage();
+    footprint.analysis = analysisEngine->getMemoryUsage();
+    footprint.fftPlans = analysisEngine->getSharedPlanMemoryUsage();
+
+    if (auto *editor = dynamic_cast<AudioPluginAudioProcessorEditor *>(getActiveEditor()))
+    {
+        footprint.editor = editor->getMemoryUsage();
+    }
+
+    return footprint;
+}
+
+juce::String MemoryFootprint::toString() const
+{
+    juce::String str;
+
+    str << "Processor: " << (juce::int64)processor << " bytes\n";
+    str << "Filter coefficients: " << (juce::int64)filterCoefficients << " bytes\n";
+    str << "Analyzer FIFOs: " << (juce::int64)analyzerFifos << " bytes\n";
+    str << "Analysis: " << (juce::int64)analysis << " bytes\n";
+    str << "Editor: " << (juce::int64)editor << " bytes\n";
+    str << "Coefficient bank (shared): " << (juce::int64)coefficientBank << " bytes\n";
+    str << "FFT plans (shared): " << (juce::int64)fftPlans << " bytes\n";
+    str << "Total: " << (juce::int64)getTotal() << " bytes";
+
+    return str;
+}
+
+template <typename SampleType>
 void AudioPluginAudioProcessor::updateLowCutFilters(const ChainSettings &chainSettings)
 {
-    auto cutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
+    auto &chain = getChain<SampleType>();
 
-    auto &leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto &rightLowCut = rightChain.get<ChainPositions::LowCut>();
+    for (auto &monoChain : chain)
+    {
+        monoChain.template setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+    }
 
-    leftChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    rightChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+    if (chainSettings.lowCutBypassed)
+    {
+        return;
+    }
 
-    updateCutFilter(leftLowCut, cutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(rightLowCut, cutCoefficients, chainSettings.lowCutSlope);
+    // Every channel shares the first channel's coefficient objects
+    auto &lowCut = chain.front().template get<ChainPositions::LowCut>();
+    auto design = getEffectiveDesign(chainSettings);
+    auto *bank = design == FilterDesign::Bilinear ? getCoefficientBank<SampleType>() : nullptr;
+    auto order = 2 * (chainSettings.lowCutSlope + 1);
+
+    if (auto *sections = bank != nullptr ? bank->getCutSections(chainSettings.lowCutFreq, order, true) : nullptr)
+    {
+        loadCutFilter(lowCut, sections, chainSettings.lowCutSlope);
+    }
+    else
+    {
+        designCutFilter(lowCut, chainSettings.lowCutFreq, chainSettings.lowCutSlope, getSampleRate(), true, design);
+    }
+
+    for (auto &monoChain : chain)
+    {
+        setCutSlope(monoChain.template get<ChainPositions::LowCut>(), chainSettings.lowCutSlope);
+    }
 }
 
+template <typename SampleType>
 void AudioPluginAudioProcessor::updateHighCutFilters(const ChainSettings &chainSettings)
 {
-    auto cutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    auto &chain = getChain<SampleType>();
 
-    auto &leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto &rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    for (auto &monoChain : chain)
+    {
+        monoChain.template setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+    }
+
+    if (chainSettings.highCutBypassed)
+    {
+        return;
+    }
 
-    leftChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    rightChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+    auto &highCut = chain.front().template get<ChainPositions::HighCut>();
+    auto design = getEffectiveDesign(chainSettings);
+    auto *bank = design == FilterDesign::Bilinear ? getCoefficientBank<SampleType>() : nullptr;
+    auto order = 2 * (chainSettings.highCutSlope + 1);
 
-    updateCutFilter(leftHighCut, cutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, cutCoefficients, chainSettings.highCutSlope);
+    if (auto *sections = bank != nullptr ? bank->getCutSections(chainSettings.highCutFreq, order, false) : nullptr)
+    {
+        loadCutFilter(highCut, sections, chainSettings.highCutSlope);
+    }
+    else
+    {
+        designCutFilter(highCut, chainSettings.highCutFreq, chainSettings.highCutSlope, getSampleRate(), false, design);
+    }
+
+    for (auto &monoChain : chain)
+    {
+        setCutSlope(monoChain.template get<ChainPositions::HighCut>(), chainSettings.highCutSlope);
+    }
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::updateStateVariableEngine(const ChainSettings &chainSettings)
+{
+    auto &engine = getStateVariableEngine<SampleType>();
+
+    auto engineChanged = chainSettings.engine != lastChainSettings.engine;
+
+    // Switching engines starts the new one from silence
+    if (engineChanged)
+    {
+        engine.reset();
+    }
+
+    engine.setLowCut(!chainSettings.lowCutBypassed, (SampleType)chainSettings.lowCutFreq, 2 * (chainSettings.lowCutSlope + 1));
+    engine.setPeak(!(chainSettings.peakBypassed || isPeakNeutral(chainSettings)), (SampleType)chainSettings.peakFreq,
+                   (SampleType)chainSettings.peakQuality, (SampleType)chainSettings.peakGainInDecibels);
+    engine.setHighCut(!chainSettings.highCutBypassed, (SampleType)chainSettings.highCutFreq, 2 * (chainSettings.highCutSlope + 1));
+    engine.finishUpdate();
+
+    // Its smoothers stood still while the biquads ran, so it starts at the current settings
+    if (engineChanged)
+    {
+        engine.skipSmoothing();
+    }
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::updateFilters(const ChainSettings &chainSettings)
+{
+    EQ_TRACE_SCOPE("updateFilters");
+
+    if (chainSettings.engine != lastChainSettings.engine)
+    {
+        resetCascade<SampleType>();
+    }
+
+    updateLowCutFilters<SampleType>(chainSettings);
+    updatePeakFilter<SampleType>(chainSettings);
+    updateHighCutFilters<SampleType>(chainSettings);
+    updateStateVariableEngine<SampleType>(chainSettings);
+
+    getCascadeVariant<SampleType>() = selectCascadeVariant<SampleType>(chainSettings);
+
+    lastChainSettings = chainSettings;
+    chainIsNeutral = isChainNeutral(chainSettings);
+
+    auto sampleRate = getSampleRate();
+    auto tail = getTailLengthInSamples(getChain<SampleType>().front(), silenceThresholdInDecibels);
+
+    tailLengthInSamples = juce::jmin(tail, maxTailLengthSeconds * sampleRate);
+    tailLengthSeconds.store(sampleRate > 0.0 ? tailLengthInSamples / sampleRate : 0.0);
 }
 
 void AudioPluginAudioProcessor::updateFilters()
 {
     auto chainSettings = getChainSettings(apvts);
 
-    updateLowCutFilters(chainSettings);
-    updatePeakFilter(chainSettings);
-    updateHighCutFilters(chainSettings);
+    if (isUsingDoublePrecision())
+        updateFilters<double>(chainSettings);
+    else
+        updateFilters<float>(chainSettings);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout AudioPluginAudioProcessor::createParameterLayout()
@@ -308,6 +1042,28 @@ juce::AudioProcessorValueTreeState::ParameterLayout AudioPluginAudioProcessor::c
     layout.add(std::make_unique<juce::AudioParameterBool>("Peak Bypassed", "Peak Bypassed", false));
     layout.add(std::make_unique<juce::AudioParameterBool>("High Cut Bypassed", "High Cut Cut Bypassed", false));
 
+    juce::StringArray engineArray;
+
+    engineArray.add("Biquad");
+    engineArray.add("State Variable");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Filter Engine", "Filter Engine", engineArray, 0));
+
+    juce::StringArray designArray;
+
+    designArray.add("Bilinear");
+    designArray.add("Matched");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Filter Design", "Filter Design", designArray, 0));
+
+    // Display only, the audio never sees it
+    juce::StringArray smoothingArray;
+
+    for (auto bandsPerOctave : analyzerSmoothingChoices)
+        smoothingArray.add(bandsPerOctave == 0 ? juce::String("Off") : "1/" + juce::String(bandsPerOctave) + " oct");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Smoothing", "Analyzer Smoothing", smoothingArray, 0));
+
     return layout;
 }
 
@@ -3,74 +3,25 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
 
+#include "AutomationTrace.h"
+#include "ButterworthDesign.h"
+#include "ChannelThreadPool.h"
+#include "CoefficientBank.h"
+#include "FrameChannel.h"
+#include "Kernels.h"
+#include "LevelMeter.h"
+#include "MatchedDesign.h"
+#include "PeakDesign.h"
+#include "RealtimeGuard.h"
+#include "StateVariableFilter.h"
+#include "Tracing.h"
+
+#include <algorithm>
 #include <array>
-template <typename T>
-struct Fifo
-{
-    void prepare(int numChannels, int numSamples)
-    {
-        static_assert(std::is_same_v<T, juce::AudioBuffer<float>>,
-                      "prepare(numChannels, numSamples) should only be used when the Fifo is holding juce::AudioBuffer<float>");
-
-        for (auto &buffer : buffers)
-        {
-            buffer.setSize(numChannels,
-                           numSamples,
-                           false, // Clear everything?
-                           true,  // Including the extra space?
-                           true); // Avoid reallocating if you can?
-            buffer.clear();
-        }
-    }
-
-    void prepare(size_t numElements)
-    {
-        static_assert(std::is_same_v<T, std::vector<float>>,
-                      "prepare(numElements) should only be used when the Fifo is holding std::vector<float>");
-
-        for (auto &buffer : buffers)
-        {
-            buffer.clear();
-            buffer.resize(numElements, 0);
-        }
-    }
-
-    bool push(const T &t)
-    {
-        auto write = fifo.write(1);
-
-        if (write.blockSize1 > 0)
-        {
-            buffers[write.startIndex1] = t;
-            return true;
-        }
+#include <memory>
+#include <vector>
 
-        return false;
-    }
-
-    bool pull(T &t)
-    {
-        auto read = fifo.read(1);
-
-        if (read.blockSize1 > 0)
-        {
-            t = buffers[read.startIndex1];
-            return true;
-        }
-
-        return false;
-    }
-
-    int getNumAvailableForReading() const
-    {
-        return fifo.getNumReady();
-    }
-
-private:
-    static constexpr int Capacity = 30;
-    std::array<T, Capacity> buffers;
-    juce::AbstractFifo fifo{Capacity};
-};
+class AnalysisEngine;
 
 enum Channel
 {
@@ -86,20 +37,24 @@ struct SingleChannelSampleFifo
         prepared.set(false);
     }
 
-    void update(const BlockType &buffer)
+    // Accepts float or double buffers, the analyzer always works in float
+    template <typename BufferType>
+    void update(const BufferType &buffer)
     {
         jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse);
+        jassert(buffer.getNumChannels() > 0);
 
-        auto *channelPtr = buffer.getReadPointer(channelToUse);
+        // Mono layouts only have the one channel to show
+        auto *channelPtr = buffer.getReadPointer(juce::jmin((int)channelToUse, buffer.getNumChannels() - 1));
 
         for (int i = 0; i < buffer.getNumSamples(); i++)
         {
-            pushNextSampleIntoFifo(channelPtr[i]);
+            pushNextSampleIntoFifo(static_cast<float>(channelPtr[i]));
         }
     }
 
-    void prepare(int bufferSize)
+    // 'numBuffers' should cover the blocks produced between two reads by the GUI
+    void prepare(int bufferSize, int numBuffers)
     {
         prepared.set(false);
         size.set(bufferSize);
@@ -109,22 +64,39 @@ struct SingleChannelSampleFifo
                              false,      // Keep existing content
                              true,       // Clear extra space
                              true);      // Avoid reallocating
+        bufferToFill.clear();
 
-        audioBufferFifo.prepare(1, bufferSize);
+        audioBufferChannel.prepare(numBuffers + 1, bufferToFill);
         fifoIndex = 0;
         prepared.set(true);
     }
 
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
+    int getNumCompleteBuffersAvailable() const { return audioBufferChannel.getNumAvailableForReading(); }
     bool isPrepared() const { return prepared.get(); }
     int getSize() const { return size.get(); }
 
-    bool getAudioBuffer(BlockType &buf) { return audioBufferFifo.pull(buf); }
+    // 'buf' is swapped into the channel, so it's resized to match first. Keep the same buffer
+    // around between calls and that only happens once.
+    bool getAudioBuffer(BlockType &buf)
+    {
+        if (buf.getNumChannels() != 1 || buf.getNumSamples() != size.get())
+            buf.setSize(1, size.get());
+
+        return audioBufferChannel.pull(buf);
+    }
+
+    // Blocks dropped because the GUI fell behind
+    juce::uint64 getNumDroppedBuffers() const { return audioBufferChannel.getNumOverflows(); }
+
+    size_t getMemoryUsage() const
+    {
+        return audioBufferChannel.getMemoryUsage() + (size_t)bufferToFill.getNumSamples() * sizeof(float);
+    }
 
 private:
     Channel channelToUse;
     int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
+    FrameChannel<BlockType> audioBufferChannel;
     BlockType bufferToFill;
 
     juce::Atomic<bool> prepared = false;
@@ -134,7 +106,8 @@ private:
     {
         if (fifoIndex == bufferToFill.getNumSamples())
         {
-            auto ok = audioBufferFifo.push(bufferToFill);
+            // Hands the block over and takes back an empty one of the same size
+            auto ok = audioBufferChannel.push(bufferToFill);
             juce::ignoreUnused(ok);
             fifoIndex = 0;
         }
@@ -152,6 +125,23 @@ enum Slope
     Slope_48
 };
 
+// Biquad runs the IIR::Filter cascade, StateVariable runs TPT sections that can be
+// modulated per sample
+enum FilterEngine
+{
+    Biquad,
+    StateVariable
+};
+
+// How the biquads are designed. Bilinear is the cookbook peak and the Butterworth cuts through
+// the bilinear transform, which squeezes their shape towards Nyquist; Matched stays much closer
+// to the analog response up there (see MatchedDesign.h).
+enum FilterDesign
+{
+    Bilinear,
+    Matched
+};
+
 struct ChainSettings
 {
     float peakFreq{0}, peakGainInDecibels{0}, peakQuality{1.0f};
@@ -160,13 +150,35 @@ struct ChainSettings
     Slope lowCutSlope{Slope::Slope_12}, highCutSlope{Slope::Slope_12};
 
     bool lowCutBypassed{false}, peakBypassed{false}, highCutBypassed{false};
+
+    FilterEngine engine{FilterEngine::Biquad};
+    FilterDesign design{FilterDesign::Bilinear};
 };
 
+bool operator==(const ChainSettings &lhs, const ChainSettings &rhs);
+bool operator!=(const ChainSettings &lhs, const ChainSettings &rhs);
+
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState &apvts);
 
-using Filter = juce::dsp::IIR::Filter<float>;
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+// The parameters getChainSettings() reads, which is what an automation trace records
+juce::StringArray getChainParameterIDs();
+
+// A 0 dB peak is an identity biquad, so it can be left out of the cascade like a bypassed one
+bool isPeakNeutral(const ChainSettings &chainSettings);
+bool isChainNeutral(const ChainSettings &chainSettings);
+
+// The design the chain is built with. The state-variable engine is bilinear whatever "Filter
+// Design" says, so its chain (which gives the tail and the drawn response) is too.
+FilterDesign getEffectiveDesign(const ChainSettings &chainSettings);
+
+template <typename SampleType>
+using Filter = juce::dsp::IIR::Filter<SampleType>;
+
+template <typename SampleType>
+using CutFilter = juce::dsp::ProcessorChain<Filter<SampleType>, Filter<SampleType>, Filter<SampleType>, Filter<SampleType>>;
+
+template <typename SampleType>
+using MonoChain = juce::dsp::ProcessorChain<CutFilter<SampleType>, Filter<SampleType>, CutFilter<SampleType>>;
 
 enum ChainPositions
 {
@@ -175,59 +187,134 @@ enum ChainPositions
     HighCut
 };
 
-using Coefficients = Filter::CoefficientsPtr;
-void updateCoefficients(Coefficients &old, const Coefficients &replacements);
+// Biquads in a MonoChain: both cuts at their steepest, and the peak
+constexpr int numCascadeSections = 2 * Butterworth::maxSections + 1;
 
-Coefficients makePeakFilter(const ChainSettings &chainSettings, double SampleRate);
+// Runs one channel of a MonoChain through the kernels, built for one combination of slopes and
+// stage bypass, see selectCascadeVariant() in PluginProcessor.cpp. 'state' is that channel's
+// CascadeState.
+template <typename SampleType>
+using CascadeVariant = void (*)(const MonoChain<SampleType> &chain, SampleType *samples, int numSamples, SampleType *state);
 
-template <int Index, typename ChainType, typename CoefficientType>
-void update(ChainType &chain, const CoefficientType &coefficients)
+// Same type as Filter<SampleType>::CoefficientsPtr, spelled out so SampleType can be deduced
+template <typename SampleType>
+using Coefficients = juce::ReferenceCountedObjectPtr<juce::dsp::IIR::Coefficients<SampleType>>;
+
+// Points every filter in 'chain' at the coefficient objects owned by 'source'.
+// Both channels always run the same settings, so they can share one set.
+template <typename SampleType>
+void shareCoefficients(MonoChain<SampleType> &chain, const MonoChain<SampleType> &source);
+
+template <typename SampleType>
+size_t getCoefficientsMemoryUsage(const MonoChain<SampleType> &chain);
+
+// How long the active sections of 'chain' take to ring down by 'attenuationInDecibels',
+// found from the pole radii of each section and summed over the cascade
+template <typename SampleType>
+double getTailLengthInSamples(const MonoChain<SampleType> &chain, double attenuationInDecibels);
+
+// Gives every filter in the chain biquad-sized coefficient storage, so the designers below
+// can write into it in place
+template <typename SampleType>
+void prepareCoefficients(MonoChain<SampleType> &chain);
+
+// Enables the first (slope + 1) sections of a cut and bypasses the rest
+template <typename ChainType>
+void setCutSlope(ChainType &chain, const Slope &slope)
 {
-    updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-    chain.template setBypassed<Index>(false);
+    chain.template setBypassed<0>(false);
+    chain.template setBypassed<1>(slope < Slope_24);
+    chain.template setBypassed<2>(slope < Slope_36);
+    chain.template setBypassed<3>(slope < Slope_48);
 }
 
-template <typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType &chain, const CoefficientType &coefficients, const Slope &slope)
+// Designs a Butterworth cut straight into the chain's own coefficient objects, nothing is allocated
+template <typename SampleType>
+void designCutFilter(CutFilter<SampleType> &chain, float frequency, const Slope &slope, double sampleRate, bool isHighPass,
+                     FilterDesign design)
 {
-    chain.template setBypassed<0>(true);
-    chain.template setBypassed<1>(true);
-    chain.template setBypassed<2>(true);
-    chain.template setBypassed<3>(true);
+    jassert(chain.template get<0>().coefficients->coefficients.size() == 5);
 
-    switch (slope)
-    {
-    case Slope_48:
-    {
-        update<3>(chain, coefficients);
-    }
-    case Slope_36:
-    {
-        update<2>(chain, coefficients);
-    }
-    case Slope_24:
-    {
-        update<1>(chain, coefficients);
-    }
-    case Slope_12:
+    std::array<SampleType *, Butterworth::maxSections> sections{
+        chain.template get<0>().coefficients->getRawCoefficients(),
+        chain.template get<1>().coefficients->getRawCoefficients(),
+        chain.template get<2>().coefficients->getRawCoefficients(),
+        chain.template get<3>().coefficients->getRawCoefficients()};
+
+    if (design == FilterDesign::Matched)
+        MatchedEQ::designCut(sections.data(), 2 * (slope + 1), frequency, sampleRate, isHighPass);
+    else
+        Butterworth::designCut(sections.data(), 2 * (slope + 1), frequency, sampleRate, isHighPass);
+
+    setCutSlope(chain, slope);
+}
+
+// Copies ready-made sections, such as those from a CoefficientBank, into the cut
+template <typename SampleType>
+void loadCutFilter(CutFilter<SampleType> &chain, const SampleType *sections, const Slope &slope)
+{
+    constexpr int sectionSize = 5;
+    jassert(chain.template get<0>().coefficients->coefficients.size() == sectionSize);
+
+    std::array<SampleType *, Butterworth::maxSections> destinations{
+        chain.template get<0>().coefficients->getRawCoefficients(),
+        chain.template get<1>().coefficients->getRawCoefficients(),
+        chain.template get<2>().coefficients->getRawCoefficients(),
+        chain.template get<3>().coefficients->getRawCoefficients()};
+
+    for (int s = 0; s <= (int)slope; s++)
     {
-        update<0>(chain, coefficients);
-    }
+        std::copy(sections + s * sectionSize, sections + (s + 1) * sectionSize, destinations[(size_t)s]);
     }
+
+    setCutSlope(chain, slope);
 }
 
-inline auto makeLowCutFilter(const ChainSettings &chainSettings, double sampleRate)
+// Designs the peak straight into the filter's own coefficient object. For the bilinear design
+// 'K' and 'A' can come from a CoefficientBank; by default they're worked out here.
+template <typename SampleType>
+void designPeakFilter(Filter<SampleType> &filter, const ChainSettings &chainSettings, double K, double A)
 {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(
-        chainSettings.lowCutFreq, sampleRate, 2 * (chainSettings.lowCutSlope + 1));
+    jassert(filter.coefficients->coefficients.size() == 5);
+
+    PeakEQ::designSection(filter.coefficients->getRawCoefficients(), K, A, chainSettings.peakQuality);
 }
 
-inline auto makeHighCutFilter(const ChainSettings &chainSettings, double sampleRate)
+template <typename SampleType>
+void designPeakFilter(Filter<SampleType> &filter, const ChainSettings &chainSettings, double sampleRate)
 {
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(
-        chainSettings.highCutFreq, sampleRate, 2 * (chainSettings.highCutSlope + 1));
+    if (getEffectiveDesign(chainSettings) == FilterDesign::Matched)
+    {
+        jassert(filter.coefficients->coefficients.size() == 5);
+
+        MatchedEQ::designPeak(filter.coefficients->getRawCoefficients(), chainSettings.peakFreq, sampleRate,
+                              chainSettings.peakQuality, chainSettings.peakGainInDecibels);
+        return;
+    }
+
+    designPeakFilter(filter, chainSettings, PeakEQ::getK(chainSettings.peakFreq, sampleRate),
+                     PeakEQ::getA(chainSettings.peakGainInDecibels));
 }
 
+// Bytes used by one plugin instance, broken down by subsystem
+struct MemoryFootprint
+{
+    size_t processor{0};          // The processor object itself, chains and FIFO headers included
+    size_t filterCoefficients{0}; // Heap-allocated coefficient objects
+    size_t analyzerFifos{0};      // Audio blocks queued for the analyzer
+    size_t analysis{0};           // Analysis engine, its buffers and the latest snapshot
+    size_t editor{0};             // Editor, analyzer and images, when an editor is open
+
+    // Shared by every instance at the same sample rate, so not part of the total
+    size_t coefficientBank{0};
+
+    // FFT plans, shared by every instance in the process, also not part of the total
+    size_t fftPlans{0};
+
+    size_t getTotal() const { return processor + filterCoefficients + analyzerFifos + analysis + editor; }
+    juce::String toString() const;
+};
+
 class AudioPluginAudioProcessor : public juce::AudioProcessor
 {
 public:
@@ -240,7 +327,8 @@ public:
     bool isBusesLayoutSupported(const BusesLayout &layouts) const override;
 
     void processBlock(juce::AudioBuffer<float> &, juce::MidiBuffer &) override;
-    using AudioProcessor::processBlock;
+    void processBlock(juce::AudioBuffer<double> &, juce::MidiBuffer &) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     juce::AudioProcessorEditor *createEditor() override;
     bool hasEditor() const override;
@@ -269,12 +357,194 @@ public:
     SingleChannelSampleFifo<BlockType> leftChannelFifo{Channel::Left};
     SingleChannelSampleFifo<BlockType> rightChannelFifo{Channel::Right};
 
+    // Held by prepareToPlay while it re-prepares the FIFOs above, and by anything pulling from
+    // them on another thread for as long as it does. The audio thread never takes it.
+    juce::CriticalSection analyzerFifoLock;
+
+    // The sample rate of the last prepareToPlay, for threads that can't call getSampleRate()
+    double getAnalysisSampleRate() const { return analysisSampleRate.load(); }
+
+    // Spectrum and response curve, kept up to date whether or not an editor is open
+    AnalysisEngine &getAnalysisEngine() { return *analysisEngine; }
+
+    // Input and output levels and output loudness, updated by every processBlock
+    MeterReadings &getMeterReadings() { return meterReadings; }
+
+    // Time spent in processBlock as a proportion of each block's duration, smoothed, and how many
+    // blocks took longer than that since prepareToPlay. Both read 0 during offline renders.
+    double getAudioLoad() const;
+    int getNumAudioOverruns() const;
+
+    // Call from the message thread
+    MemoryFootprint getMemoryFootprint() const;
+
+    // When enabled, offline renders spread the channels of wide buses over all cores.
+    // Realtime processing always stays on the audio thread.
+    void setMultithreadedRenderingEnabled(bool shouldBeEnabled);
+    bool isMultithreadedRenderingEnabled() const;
+
+    // When enabled, settings changes look coefficients up in a process-wide CoefficientBank
+    // for the current sample rate instead of designing them. Takes effect on the next
+    // prepareToPlay; if the bank's memory budget is used up, filters are designed as usual.
+    // Off by default; setting EQUALIZER_COEFFICIENT_BANK to anything but 0 turns it on for
+    // every instance.
+    void setCoefficientBankEnabled(bool shouldBeEnabled);
+    bool isCoefficientBankEnabled() const;
+
+    // Call from the message thread. 0 when no bank is in use.
+    double getCoefficientBankBuildTimeSeconds() const;
+
+    // Records the chain parameters and size of every block into 'file' until stopped, for
+    // tools/TraceReplay.cpp (see AutomationTrace.h). Setting EQUALIZER_AUTOMATION_TRACE to a
+    // directory starts a trace there for every instance. Call from the message thread.
+    bool startAutomationTrace(const juce::File &file);
+    void stopAutomationTrace();
+    bool isRecordingAutomationTrace() const;
+
 private:
-    MonoChain leftChain, rightChain;
+    std::unique_ptr<AnalysisEngine> analysisEngine;
+
+    // Shared by every instance in the process, writes nothing unless tracing is compiled in
+    juce::SharedResourcePointer<Tracing::Writer> traceWriter;
+
+    // One chain per channel, all sharing the coefficient objects of the first
+    template <typename SampleType>
+    using MultiChannelChain = std::vector<MonoChain<SampleType>>;
+
+    // Only the chain matching the host's processing precision is updated and run
+    MultiChannelChain<float> floatChain;
+    MultiChannelChain<double> doubleChain;
+
+    template <typename SampleType>
+    MultiChannelChain<SampleType> &getChain()
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleChain;
+        else
+            return floatChain;
+    }
+
+    // The chains are designed as usual but run through Kernels::processCascade, which keeps
+    // its filter state here: per channel, two values for each section of the chain
+    template <typename SampleType>
+    using CascadeState = std::array<SampleType, 2 * numCascadeSections>;
+
+    std::vector<CascadeState<float>> floatCascadeStates;
+    std::vector<CascadeState<double>> doubleCascadeStates;
+
+    template <typename SampleType>
+    std::vector<CascadeState<SampleType>> &getCascadeStates()
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleCascadeStates;
+        else
+            return floatCascadeStates;
+    }
+
+    // Picked whenever the settings change, so processing a block doesn't look at bypass at all
+    CascadeVariant<float> floatCascadeVariant = nullptr;
+    CascadeVariant<double> doubleCascadeVariant = nullptr;
+
+    template <typename SampleType>
+    CascadeVariant<SampleType> &getCascadeVariant()
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleCascadeVariant;
+        else
+            return floatCascadeVariant;
+    }
+
+    template <typename SampleType>
+    void resetCascade();
+
+    // The state-variable engine, used instead of the chains when "Filter Engine" asks for it.
+    // The chains still get designed, as they provide the tail and the identical response.
+    StateVariableEngine<float> floatStateVariableEngine;
+    StateVariableEngine<double> doubleStateVariableEngine;
+
+    template <typename SampleType>
+    StateVariableEngine<SampleType> &getStateVariableEngine()
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleStateVariableEngine;
+        else
+            return floatStateVariableEngine;
+    }
+
+    template <typename SampleType>
+    struct Meters
+    {
+        LevelMeter<SampleType> input, output;
+    };
+
+    Meters<float> floatMeters;
+    Meters<double> doubleMeters;
+    MeterReadings meterReadings;
+
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+
+    AutomationTrace::Recorder automationTrace{apvts, getChainParameterIDs()};
+
+    template <typename SampleType>
+    Meters<SampleType> &getMeters()
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleMeters;
+        else
+            return floatMeters;
+    }
+
+    std::atomic<bool> coefficientBankEnabled{false};
+    juce::SharedResourcePointer<CoefficientBankCache> coefficientBankCache;
+    std::shared_ptr<const CoefficientBank<float>> floatCoefficientBank;
+    std::shared_ptr<const CoefficientBank<double>> doubleCoefficientBank;
+
+    template <typename SampleType>
+    const CoefficientBank<SampleType> *getCoefficientBank() const
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleCoefficientBank.get();
+        else
+            return floatCoefficientBank.get();
+    }
+
+    template <typename SampleType>
+    void prepareChain(const juce::dsp::ProcessSpec &spec, int numChannels);
+
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType> &buffer);
+
+    // Below this many channels, waking the pool costs more than it saves
+    static constexpr int minChannelsForMultithreading = 4;
+
+    std::atomic<bool> multithreadedRenderingEnabled{true};
+    juce::SharedResourcePointer<ChannelThreadPool> channelThreadPool;
+
+    // Anything below this is treated as silence, and tails are measured down to it
+    static constexpr double silenceThresholdInDecibels = -120.0;
+    static constexpr double maxTailLengthSeconds = 10.0;
+
+    ChainSettings lastChainSettings;
+    bool chainIsNeutral = false;
+
+    // Only touched on the audio thread, apart from prepareToPlay
+    double tailLengthInSamples = 0.0;
+    double numSilentSamples = 0.0;
+    bool chainIsFlushed = false;
+
+    std::atomic<double> tailLengthSeconds{0.0};
+    std::atomic<double> analysisSampleRate{0.0};
 
+    template <typename SampleType>
     void updatePeakFilter(const ChainSettings &ChainSettings);
+    template <typename SampleType>
     void updateLowCutFilters(const ChainSettings &ChainSettings);
+    template <typename SampleType>
     void updateHighCutFilters(const ChainSettings &ChainSettings);
+    template <typename SampleType>
+    void updateStateVariableEngine(const ChainSettings &chainSettings);
+    template <typename SampleType>
+    void updateFilters(const ChainSettings &chainSettings);
     void updateFilters();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioPluginAudioProcessor)
@@ -0,0 +1,361 @@
+#include "RealtimeGuard.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if EQUALIZER_REALTIME_GUARD_INTERPOSE
+#include <dlfcn.h>
+#include <pthread.h>
+#endif
+
+#if EQUALIZER_REALTIME_GUARD_INTERPOSE && (JUCE_GCC || JUCE_CLANG)
+// Dynamic TLS can call malloc on a thread's first access, which would recurse into the hooks
+#define EQUALIZER_REALTIME_GUARD_TLS __attribute__((tls_model("initial-exec")))
+#else
+#define EQUALIZER_REALTIME_GUARD_TLS
+#endif
+
+namespace RealtimeGuard
+{
+namespace
+{
+std::atomic<Action> action{Action::Report};
+std::atomic<int> numViolations{0};
+
+// Only the first few are printed, a violation inside processBlock usually repeats every block
+constexpr int maxReports = 8;
+
+// Plain ints, so they're safe to touch from malloc on any thread at any time
+EQUALIZER_REALTIME_GUARD_TLS thread_local int realtimeDepth = 0;
+EQUALIZER_REALTIME_GUARD_TLS thread_local int allowanceDepth = 0;
+
+[[maybe_unused]] bool isViolation()
+{
+    return realtimeDepth > 0 && allowanceDepth == 0;
+}
+
+[[maybe_unused]] void reportViolation(const char *what)
+{
+    // The report itself allocates, so let it
+    ++allowanceDepth;
+
+    auto count = ++numViolations;
+    auto shouldAbort = action.load() == Action::Abort;
+
+    if (shouldAbort || count <= maxReports)
+    {
+        auto backtrace = juce::SystemStats::getStackBacktrace();
+        std::fprintf(stderr, "RealtimeGuard: %s on a realtime thread\n%s\n", what, backtrace.toRawUTF8());
+    }
+
+    if (shouldAbort)
+        std::abort();
+
+    --allowanceDepth;
+}
+
+#if EQUALIZER_REALTIME_GUARD
+// With the C allocator wrapped, malloc and free do the checking for the operators as well
+constexpr bool checksInOperators = !interposesLibc();
+
+void *checkedAllocate(std::size_t size)
+{
+    if (checksInOperators && isViolation())
+        reportViolation("allocation");
+
+    if (auto *ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void checkedFree(void *ptr)
+{
+    if (checksInOperators && ptr != nullptr && isViolation())
+        reportViolation("deallocation");
+
+    std::free(ptr);
+}
+
+void *checkedAllocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    if (checksInOperators && isViolation())
+        reportViolation("allocation");
+
+#if JUCE_WINDOWS
+    if (auto *ptr = _aligned_malloc(size == 0 ? 1 : size, (std::size_t)alignment))
+        return ptr;
+#else
+    void *ptr = nullptr;
+
+    if (posix_memalign(&ptr, juce::jmax((std::size_t)alignment, sizeof(void *)), size == 0 ? 1 : size) == 0)
+        return ptr;
+#endif
+
+    throw std::bad_alloc();
+}
+
+void checkedFreeAligned(void *ptr)
+{
+    if (checksInOperators && ptr != nullptr && isViolation())
+        reportViolation("deallocation");
+
+#if JUCE_WINDOWS
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+#endif
+} // namespace
+
+void setAction(Action newAction)
+{
+    action.store(newAction);
+}
+
+Action getAction()
+{
+    return action.load();
+}
+
+int getNumViolations()
+{
+    return numViolations.load();
+}
+
+ScopedRealtimeSection::ScopedRealtimeSection(bool shouldBeActive) : active(isCompiledIn() && shouldBeActive)
+{
+    if (active)
+        ++realtimeDepth;
+}
+
+ScopedRealtimeSection::~ScopedRealtimeSection()
+{
+    if (active)
+        --realtimeDepth;
+}
+
+ScopedAllowance::ScopedAllowance()
+{
+    ++allowanceDepth;
+}
+
+ScopedAllowance::~ScopedAllowance()
+{
+    --allowanceDepth;
+}
+} // namespace RealtimeGuard
+
+#if EQUALIZER_REALTIME_GUARD
+// Replacing the global operators catches everything in this binary, JUCE included
+void *operator new(std::size_t size) { return RealtimeGuard::checkedAllocate(size); }
+void *operator new[](std::size_t size) { return RealtimeGuard::checkedAllocate(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return RealtimeGuard::checkedAllocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void *ptr) noexcept { RealtimeGuard::checkedFree(ptr); }
+void operator delete[](void *ptr) noexcept { RealtimeGuard::checkedFree(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { RealtimeGuard::checkedFree(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { RealtimeGuard::checkedFree(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { RealtimeGuard::checkedFree(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { RealtimeGuard::checkedFree(ptr); }
+
+// Over-aligned types, which the standard library would otherwise allocate behind our back
+void *operator new(std::size_t size, std::align_val_t alignment) { return RealtimeGuard::checkedAllocateAligned(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return RealtimeGuard::checkedAllocateAligned(size, alignment); }
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return RealtimeGuard::checkedAllocateAligned(size, alignment);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept { RealtimeGuard::checkedFreeAligned(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { RealtimeGuard::checkedFreeAligned(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { RealtimeGuard::checkedFreeAligned(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { RealtimeGuard::checkedFreeAligned(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { RealtimeGuard::checkedFreeAligned(ptr); }
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { RealtimeGuard::checkedFreeAligned(ptr); }
+#endif
+
+#if EQUALIZER_REALTIME_GUARD_INTERPOSE
+// glibc declares its C functions noexcept in C++, other libcs don't
+#if defined(__GLIBC__)
+#define EQUALIZER_LIBC_NOEXCEPT noexcept
+#else
+#define EQUALIZER_LIBC_NOEXCEPT
+#endif
+
+namespace
+{
+using MallocFunction = void *(*)(std::size_t);
+using CallocFunction = void *(*)(std::size_t, std::size_t);
+using ReallocFunction = void *(*)(void *, std::size_t);
+using FreeFunction = void (*)(void *);
+using MemalignFunction = int (*)(void **, std::size_t, std::size_t);
+using LockFunction = int (*)(pthread_mutex_t *);
+
+std::atomic<MallocFunction> realMalloc{nullptr};
+std::atomic<CallocFunction> realCalloc{nullptr};
+std::atomic<ReallocFunction> realRealloc{nullptr};
+std::atomic<FreeFunction> realFree{nullptr};
+std::atomic<MemalignFunction> realMemalign{nullptr};
+std::atomic<LockFunction> realLock{nullptr};
+
+// dlsym can allocate while the real functions are still being looked up, so until then
+// allocations come out of this, and are never freed
+std::atomic<bool> isResolving{false};
+alignas(std::max_align_t) char bootstrapArena[8192];
+std::atomic<std::size_t> bootstrapUsed{0};
+
+void *bootstrapAllocate(std::size_t size)
+{
+    constexpr auto alignment = alignof(std::max_align_t);
+    size = (size + alignment - 1) / alignment * alignment;
+
+    auto offset = bootstrapUsed.fetch_add(size);
+    return offset + size <= sizeof(bootstrapArena) ? bootstrapArena + offset : nullptr;
+}
+
+bool isBootstrapPointer(void *ptr)
+{
+    return ptr >= (void *)bootstrapArena && ptr < (void *)(bootstrapArena + sizeof(bootstrapArena));
+}
+
+template <typename Function>
+Function lookUp(const char *name)
+{
+    return reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+}
+
+void resolveAllocator()
+{
+    if (realFree.load() != nullptr)
+        return;
+
+    isResolving = true;
+    realMalloc = lookUp<MallocFunction>("malloc");
+    realCalloc = lookUp<CallocFunction>("calloc");
+    realRealloc = lookUp<ReallocFunction>("realloc");
+    realMemalign = lookUp<MemalignFunction>("posix_memalign");
+    realFree = lookUp<FreeFunction>("free");
+    isResolving = false;
+}
+
+void checkAllocation()
+{
+    if (RealtimeGuard::isViolation())
+        RealtimeGuard::reportViolation("allocation");
+}
+} // namespace
+
+// Defining these here takes over the calls made from this binary, which is what catches
+// juce::HeapBlock and so AudioBuffer, Array and MemoryBlock, none of which go through new
+extern "C" void *malloc(std::size_t size) EQUALIZER_LIBC_NOEXCEPT
+{
+    if (isResolving)
+        return bootstrapAllocate(size);
+
+    resolveAllocator();
+    checkAllocation();
+
+    return realMalloc.load()(size);
+}
+
+extern "C" void *calloc(std::size_t numElements, std::size_t size) EQUALIZER_LIBC_NOEXCEPT
+{
+    // The arena is zeroed, and nothing in it is reused
+    if (isResolving)
+        return bootstrapAllocate(numElements * size);
+
+    resolveAllocator();
+    checkAllocation();
+
+    return realCalloc.load()(numElements, size);
+}
+
+extern "C" void *realloc(void *ptr, std::size_t size) EQUALIZER_LIBC_NOEXCEPT
+{
+    resolveAllocator();
+    checkAllocation();
+
+    if (isBootstrapPointer(ptr))
+    {
+        // Only dlsym's own buffers live there, so this hardly ever happens
+        auto *moved = realMalloc.load()(size);
+
+        if (moved != nullptr)
+            std::memcpy(moved, ptr, juce::jmin(size, (std::size_t)(bootstrapArena + sizeof(bootstrapArena) - (char *)ptr)));
+
+        return moved;
+    }
+
+    return realRealloc.load()(ptr, size);
+}
+
+extern "C" int posix_memalign(void **result, std::size_t alignment, std::size_t size) EQUALIZER_LIBC_NOEXCEPT
+{
+    resolveAllocator();
+    checkAllocation();
+
+    return realMemalign.load()(result, alignment, size);
+}
+
+extern "C" void free(void *ptr) EQUALIZER_LIBC_NOEXCEPT
+{
+    if (ptr == nullptr || isBootstrapPointer(ptr))
+        return;
+
+    if (RealtimeGuard::isViolation())
+        RealtimeGuard::reportViolation("deallocation");
+
+    resolveAllocator();
+    realFree.load()(ptr);
+}
+
+// Covers juce::CriticalSection, std::mutex and anything else built on pthreads. Trylock is
+// left alone, as it never blocks.
+extern "C" int pthread_mutex_lock(pthread_mutex_t *mutex) EQUALIZER_LIBC_NOEXCEPT
+{
+    // Not a function-local static, whose initialisation guard could lock a mutex itself
+    auto lock = realLock.load();
+
+    if (lock == nullptr)
+    {
+        lock = lookUp<LockFunction>("pthread_mutex_lock");
+        realLock = lock;
+    }
+
+    if (RealtimeGuard::isViolation())
+        RealtimeGuard::reportViolation("mutex lock");
+
+    return lock(mutex);
+}
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Built with EQUALIZER_REALTIME_GUARD=1 (the CMake option of the same name), every heap
+// allocation, free and mutex lock made on a thread inside a ScopedRealtimeSection counts as a
+// violation, and is reported with a stack trace or aborts the process. Without the flag the
+// guard compiles to nothing, so the sections can stay in processBlock for good.
+#ifndef EQUALIZER_REALTIME_GUARD
+#define EQUALIZER_REALTIME_GUARD 0
+#endif
+
+// Where dlsym(RTLD_NEXT) is available, malloc, calloc, realloc, posix_memalign, free and
+// pthread_mutex_lock are wrapped as well as new and delete
+#if EQUALIZER_REALTIME_GUARD && (JUCE_LINUX || JUCE_BSD || JUCE_MAC)
+#define EQUALIZER_REALTIME_GUARD_INTERPOSE 1
+#else
+#define EQUALIZER_REALTIME_GUARD_INTERPOSE 0
+#endif
+
+namespace RealtimeGuard
+{
+enum class Action
+{
+    Report, // Print the first few violations and their stack traces to stderr
+    Abort   // Print the stack trace and abort, for running under a debugger or in CI
+};
+
+// Process-wide, can be called from any thread
+void setAction(Action newAction);
+Action getAction();
+
+// Violations seen since the process started
+int getNumViolations();
+
+constexpr bool isCompiledIn() { return EQUALIZER_REALTIME_GUARD != 0; }
+
+// Whether the C allocator and mutexes are checked, see above. Without that, JUCE's HeapBlock
+// (and so AudioBuffer, Array and MemoryBlock) go unseen.
+constexpr bool interposesLibc() { return EQUALIZER_REALTIME_GUARD_INTERPOSE != 0; }
+
+// Marks the calling thread as realtime until the section ends. Sections can nest.
+class ScopedRealtimeSection
+{
+public:
+    explicit ScopedRealtimeSection(bool shouldBeActive = true);
+    ~ScopedRealtimeSection();
+
+private:
+    bool active;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeSection)
+};
+
+// Lets something that is known to lock or allocate run inside a realtime section
+class ScopedAllowance
+{
+public:
+    ScopedAllowance();
+    ~ScopedAllowance();
+
+private:
+    JUCE_DECLARE_NON_COPYABLE(ScopedAllowance)
+};
+} // namespace RealtimeGuard
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+// Slow, plain double-precision version of the biquad chain, for checking the real one
+// against. It designs from the RBJ cookbook formulas (cos/sin of w0, not the tan() form the
+// processor uses) and runs direct form I, so it shares no code with the production path
+// beyond the settings themselves. Nothing here is meant for the audio thread.
+namespace ReferenceCascade
+{
+struct Section
+{
+    double b0{1}, b1{0}, b2{0}, a1{0}, a2{0};
+    double x1{0}, x2{0}, y1{0}, y2{0};
+
+    double process(double x)
+    {
+        auto y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+
+        return y;
+    }
+};
+
+inline Section makeSection(double b0, double b1, double b2, double a0, double a1, double a2)
+{
+    Section s;
+    s.b0 = b0 / a0;
+    s.b1 = b1 / a0;
+    s.b2 = b2 / a0;
+    s.a1 = a1 / a0;
+    s.a2 = a2 / a0;
+    return s;
+}
+
+// One Butterworth section of the given order, Q_k = 1 / (2 cos((2k + 1) pi / 2n))
+inline Section makeCutSection(double frequency, double sampleRate, int order, int section, bool isHighPass)
+{
+    const double pi = 3.14159265358979323846;
+
+    auto quality = 1.0 / (2.0 * std::cos((2.0 * section + 1.0) * pi / (2.0 * order)));
+    auto w0 = 2.0 * pi * frequency / sampleRate;
+    auto cosW0 = std::cos(w0);
+    auto alpha = std::sin(w0) / (2.0 * quality);
+
+    if (isHighPass)
+        return makeSection((1.0 + cosW0) / 2.0, -(1.0 + cosW0), (1.0 + cosW0) / 2.0, 1.0 + alpha, -2.0 * cosW0, 1.0 - alpha);
+
+    return makeSection((1.0 - cosW0) / 2.0, 1.0 - cosW0, (1.0 - cosW0) / 2.0, 1.0 + alpha, -2.0 * cosW0, 1.0 - alpha);
+}
+
+inline Section makePeakSection(double frequency, double sampleRate, double quality, double gainInDecibels)
+{
+    const double pi = 3.14159265358979323846;
+
+    auto A = std::pow(10.0, gainInDecibels / 40.0);
+    auto w0 = 2.0 * pi * frequency / sampleRate;
+    auto cosW0 = std::cos(w0);
+    auto alpha = std::sin(w0) / (2.0 * quality);
+
+    return makeSection(1.0 + alpha * A, -2.0 * cosW0, 1.0 - alpha * A, 1.0 + alpha / A, -2.0 * cosW0, 1.0 - alpha / A);
+}
+
+// Builds the cascade for one channel. 'Settings' is ChainSettings, kept generic so this
+// header doesn't drag in the processor.
+template <typename Settings>
+std::vector<Section> makeCascade(const Settings &settings, double sampleRate)
+{
+    std::vector<Section> sections;
+
+    if (!settings.lowCutBypassed)
+    {
+        auto order = 2 * ((int)settings.lowCutSlope + 1);
+
+        for (int s = 0; s < order / 2; s++)
+            sections.push_back(makeCutSection(settings.lowCutFreq, sampleRate, order, s, true));
+    }
+
+    if (!settings.peakBypassed)
+        sections.push_back(makePeakSection(settings.peakFreq, sampleRate, settings.peakQuality, settings.peakGainInDecibels));
+
+    if (!settings.highCutBypassed)
+    {
+        auto order = 2 * ((int)settings.highCutSlope + 1);
+
+        for (int s = 0; s < order / 2; s++)
+            sections.push_back(makeCutSection(settings.highCutFreq, sampleRate, order, s, false));
+    }
+
+    return sections;
+}
+
+// Runs 'numSamples' of one channel through the reference cascade, in place
+template <typename Settings, typename SampleType>
+void render(const Settings &settings, double sampleRate, SampleType *data, int numSamples)
+{
+    auto sections = makeCascade(settings, sampleRate);
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        auto x = (double)data[i];
+
+        for (auto &section : sections)
+            x = section.process(x);
+
+        data[i] = (SampleType)x;
+    }
+}
+
+// Largest absolute difference between two renders, for comparing against a tolerance
+template <typename SampleType>
+double getMaxDifference(const SampleType *a, const SampleType *b, int numSamples)
+{
+    double difference = 0.0;
+
+    for (int i = 0; i < numSamples; i++)
+        difference = std::max(difference, std::abs((double)a[i] - (double)b[i]));
+
+    return difference;
+}
+} // namespace ReferenceCascade
@@ -0,0 +1,109 @@
+#include "SharedMemoryPublisher.h"
+#include "AnalysisEngine.h"
+
+#include <cstddef>
+#include <cstring>
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+#define EQUALIZER_HAS_POSIX_SHM 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define EQUALIZER_HAS_POSIX_SHM 0
+#endif
+
+SharedMemoryPublisher::SharedMemoryPublisher()
+{
+}
+
+SharedMemoryPublisher::~SharedMemoryPublisher()
+{
+    close();
+}
+
+bool SharedMemoryPublisher::open()
+{
+    close();
+
+#if EQUALIZER_HAS_POSIX_SHM
+    static std::atomic<int> instanceCounter{0};
+
+    name = "/" + juce::String(SharedMonitor::namePrefix) + juce::String((int)getpid()) + "-" + juce::String(++instanceCounter);
+
+    auto fd = shm_open(name.toRawUTF8(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+
+    if (fd < 0)
+        return false;
+
+    auto size = SharedMonitor::getBlockSize();
+    void *memory = MAP_FAILED;
+
+    if (ftruncate(fd, (off_t)size) == 0)
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    ::close(fd);
+
+    if (memory == MAP_FAILED)
+    {
+        shm_unlink(name.toRawUTF8());
+        return false;
+    }
+
+    // ftruncate() zero-fills, so every frame starts with an even sequence and no bins
+    header = static_cast<SharedMonitor::Header *>(memory);
+    header->headerSize = (std::uint32_t)offsetof(SharedMonitor::Header, frames);
+    header->frameSize = (std::uint32_t)sizeof(SharedMonitor::Frame);
+    header->numFrames = (std::uint32_t)SharedMonitor::ringSize;
+    header->maxBins = (std::uint32_t)SharedMonitor::maxBins;
+    header->version = SharedMonitor::version;
+    header->writeCount.store(0);
+
+    // Readers check the magic last, so they never see a half-written header
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SharedMonitor::magic;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SharedMemoryPublisher::close()
+{
+#if EQUALIZER_HAS_POSIX_SHM
+    if (header != nullptr)
+    {
+        munmap(header, SharedMonitor::getBlockSize());
+        shm_unlink(name.toRawUTF8());
+    }
+#endif
+
+    header = nullptr;
+    name = {};
+}
+
+void SharedMemoryPublisher::publish(const AnalysisSnapshot &snapshot)
+{
+    if (header == nullptr)
+        return;
+
+    auto count = header->writeCount.load(std::memory_order_relaxed);
+    auto &frame = header->frames[count % SharedMonitor::ringSize];
+
+    auto sequence = frame.sequence.load(std::memory_order_relaxed);
+    frame.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto numBins = juce::jmin((int)snapshot.spectrum.size(), SharedMonitor::maxBins);
+
+    frame.numBins = (std::uint32_t)numBins;
+    frame.frameIndex = snapshot.frameIndex;
+    frame.sampleRate = snapshot.sampleRate;
+    frame.peakDecibels = snapshot.peakDecibels;
+    frame.rmsDecibels = snapshot.rmsDecibels;
+    std::memcpy(frame.spectrumDecibels, snapshot.spectrum.data(), (size_t)numBins * sizeof(float));
+
+    frame.sequence.store(sequence + 2, std::memory_order_release);
+    header->writeCount.store(count + 1, std::memory_order_release);
+}
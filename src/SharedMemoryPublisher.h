@@ -0,0 +1,33 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include "SharedMonitorLayout.h"
+
+struct AnalysisSnapshot;
+
+// Exports analysis frames through a POSIX shared-memory block (see SharedMonitorLayout.h), so a
+// local monitoring process can read every instance's levels and spectrum without a GUI. Only
+// the analysis thread writes to it; the audio thread never goes near it. On platforms without
+// POSIX shared memory, open() fails and nothing is published.
+class SharedMemoryPublisher
+{
+public:
+    SharedMemoryPublisher();
+    ~SharedMemoryPublisher();
+
+    // Creates the block, named after the process and a per-process instance counter
+    bool open();
+    void close();
+
+    bool isOpen() const { return header != nullptr; }
+    juce::String getName() const { return name; }
+
+    void publish(const AnalysisSnapshot &snapshot);
+
+private:
+    juce::String name;
+    SharedMonitor::Header *header = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedMemoryPublisher)
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Layout of the shared-memory block an instance exports its meters and spectrum through.
+// Shared by the plugin and tools/MonitorReader.cpp, so nothing in here depends on JUCE.
+//
+// The block is a header followed by a ring of frames. The writer fills the ring in order,
+// each one guarded by a seqlock: 'sequence' is odd while the frame is being written and
+// even once it's done. A reader takes 'writeCount - 1' as the newest frame, reads it in
+// place, and keeps the result only if 'sequence' was even and unchanged across the read.
+namespace SharedMonitor
+{
+constexpr std::uint32_t magic = 0x45514d4e; // "EQMN"
+constexpr std::uint32_t version = 1;
+
+constexpr int maxBins = 4096;
+constexpr int ringSize = 8;
+
+// Instances are found as "/<namePrefix><pid>-<instance>"
+constexpr const char *namePrefix = "eqplugin-";
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "Atomics in shared memory must be lock-free");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Atomics in shared memory must be lock-free");
+
+struct Frame
+{
+    std::atomic<std::uint32_t> sequence;
+    std::uint32_t numBins;
+
+    std::uint64_t frameIndex;
+    double sampleRate;
+
+    // Output level of the analysed channel since the previous frame
+    float peakDecibels;
+    float rmsDecibels;
+
+    float spectrumDecibels[maxBins];
+};
+
+struct Header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t frameSize;
+    std::uint32_t numFrames;
+    std::uint32_t maxBins;
+
+    std::atomic<std::uint64_t> writeCount; // Frames published so far
+
+    Frame frames[ringSize];
+};
+
+constexpr std::size_t getBlockSize() { return sizeof(Header); }
+} // namespace SharedMonitor
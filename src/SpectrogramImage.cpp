@@ -0,0 +1,110 @@
+#include "SpectrogramImage.h"
+
+SpectrogramImage::SpectrogramImage()
+{
+    // Dark to the editor's purple and teal, then white for the loudest
+    juce::ColourGradient gradient(juce::Colours::black, 0.0f, 0.0f, juce::Colours::white, 1.0f, 0.0f, false);
+    gradient.addColour(0.35, juce::Colour(187u, 134u, 252u));
+    gradient.addColour(0.7, juce::Colour(3u, 218u, 197u));
+
+    for (int i = 0; i < numColours; i++)
+        colourMap[(size_t)i] = gradient.getColourAtPosition((double)i / (numColours - 1)).getPixelARGB();
+}
+
+void SpectrogramImage::setSize(int width, int height)
+{
+    width = juce::jmax(1, width);
+    height = juce::jmax(1, height);
+
+    if (image.isNull() || image.getWidth() != width || image.getHeight() != height)
+    {
+        // A software image, so writing a column is just a few stores
+        image = juce::Image(juce::Image::RGB, width, height, true, juce::SoftwareImageType());
+        mappedFFTSize = 0;
+    }
+
+    clear();
+}
+
+void SpectrogramImage::clear()
+{
+    if (image.isValid())
+        image.clear(image.getBounds(), juce::Colours::black);
+
+    nextColumn = 0;
+}
+
+void SpectrogramImage::updateRowBins(int fftSize, double sampleRate)
+{
+    if (fftSize == mappedFFTSize && sampleRate == mappedSampleRate && (int)rowBins.size() == image.getHeight())
+        return;
+
+    auto height = image.getHeight();
+    auto numBins = fftSize / 2;
+    auto binWidth = sampleRate / fftSize;
+
+    rowBins.resize((size_t)height);
+
+    for (int row = 0; row < height; row++)
+    {
+        // Row 0 is the top, so the highest frequencies
+        auto high = juce::mapToLog10(1.0 - (double)row / height, 20.0, 20000.0);
+        auto low = juce::mapToLog10(1.0 - (double)(row + 1) / height, 20.0, 20000.0);
+
+        auto first = juce::jlimit(1, numBins - 1, (int)std::floor(low / binWidth + 0.5));
+        auto last = juce::jlimit(first, numBins - 1, (int)std::floor(high / binWidth + 0.5));
+
+        rowBins[(size_t)row] = {first, last};
+    }
+
+    mappedFFTSize = fftSize;
+    mappedSampleRate = sampleRate;
+}
+
+void SpectrogramImage::addColumn(const std::vector<float> &spectrum, int fftSize, double sampleRate)
+{
+    if (image.isNull() || fftSize < 4 || (int)spectrum.size() < fftSize / 2 || sampleRate <= 0.0)
+        return;
+
+    updateRowBins(fftSize, sampleRate);
+
+    const juce::Image::BitmapData pixels(image, nextColumn, 0, 1, image.getHeight(), juce::Image::BitmapData::writeOnly);
+
+    for (int row = 0; row < image.getHeight(); row++)
+    {
+        // Where a row spans several bins, the loudest one shows, so narrow peaks don't vanish
+        const auto &bins = rowBins[(size_t)row];
+        auto decibels = minDecibels;
+
+        for (int bin = bins.first; bin <= bins.last; bin++)
+            decibels = juce::jmax(decibels, spectrum[(size_t)bin]);
+
+        auto index = juce::jlimit(0, numColours - 1,
+                                  (int)((decibels - minDecibels) * (numColours - 1) / (maxDecibels - minDecibels)));
+
+        reinterpret_cast<juce::PixelRGB *>(pixels.getPixelPointer(0, row))->set(colourMap[(size_t)index]);
+    }
+
+    nextColumn = (nextColumn + 1) % image.getWidth();
+}
+
+void SpectrogramImage::draw(juce::Graphics &g, juce::Rectangle<int> area) const
+{
+    if (image.isNull())
+        return;
+
+    // The columns from 'nextColumn' on are the oldest, so they go first
+    auto width = image.getWidth();
+    auto height = image.getHeight();
+    auto numOldest = width - nextColumn;
+
+    g.drawImage(image, area.getX(), area.getY(), numOldest, area.getHeight(), nextColumn, 0, numOldest, height);
+
+    if (nextColumn > 0)
+        g.drawImage(image, area.getX() + numOldest, area.getY(), nextColumn, area.getHeight(), 0, 0, nextColumn, height);
+}
+
+size_t SpectrogramImage::getMemoryUsage() const
+{
+    return sizeof(*this) + (size_t)(image.getWidth() * image.getHeight()) * 3 + rowBins.capacity() * sizeof(RowBins);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include <array>
+#include <vector>
+
+// Scrolling time-frequency view kept in a ring image: one column per spectrum, time running
+// left to right, frequency on a log scale from 20 Hz at the bottom to 20 kHz at the top.
+// Adding a column writes that column only, and drawing is two blits, so the cost per frame
+// doesn't depend on how much history is kept.
+class SpectrogramImage
+{
+public:
+    SpectrogramImage();
+
+    // One column per pixel of width, so 'width' is also the number of frames of history.
+    // Clears the history.
+    void setSize(int width, int height);
+    void clear();
+
+    // 'spectrum' as in AnalysisSnapshot: fftSize / 2 bins in decibels
+    void addColumn(const std::vector<float> &spectrum, int fftSize, double sampleRate);
+
+    // Oldest column on the left, newest on the right
+    void draw(juce::Graphics &g, juce::Rectangle<int> area) const;
+
+    size_t getMemoryUsage() const;
+
+private:
+    static constexpr float minDecibels = -96.0f;
+    static constexpr float maxDecibels = 0.0f;
+    static constexpr int numColours = 256;
+
+    juce::Image image;
+    int nextColumn = 0;
+
+    std::array<juce::PixelARGB, numColours> colourMap;
+
+    // For each row, top to bottom, the bins it covers. Depends on the height, FFT size and
+    // sample rate, and is only rebuilt when one of them changes.
+    struct RowBins
+    {
+        int first, last;
+    };
+
+    std::vector<RowBins> rowBins;
+    int mappedFFTSize = 0;
+    double mappedSampleRate = 0.0;
+
+    void updateRowBins(int fftSize, double sampleRate);
+};
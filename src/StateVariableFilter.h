@@ -0,0 +1,366 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "ButterworthDesign.h"
+
+#include <array>
+#include <vector>
+
+// Topology-preserving-transform state-variable section (Zavalishin, Simper).
+// The section is driven by g = tan(pi * fc / fs) and k = 1 / Q directly, so changing
+// frequency or Q costs a division and a few multiplies, with nothing to allocate, and
+// the state stays valid however fast the parameters move.
+template <typename SampleType>
+struct SvfSection
+{
+    SampleType ic1eq{0}, ic2eq{0};
+
+    void reset()
+    {
+        ic1eq = 0;
+        ic2eq = 0;
+    }
+
+    // Output is m0 * input + m1 * bandpass + m2 * lowpass
+    SampleType processSample(SampleType v0, SampleType g, SampleType k, SampleType m0, SampleType m1, SampleType m2)
+    {
+        auto a1 = SampleType(1) / (SampleType(1) + g * (g + k));
+        auto a2 = g * a1;
+        auto a3 = g * a2;
+
+        auto v3 = v0 - ic2eq;
+        auto v1 = a1 * ic1eq + a2 * v3;
+        auto v2 = ic2eq + a2 * ic1eq + a3 * v3;
+
+        ic1eq = SampleType(2) * v1 - ic1eq;
+        ic2eq = SampleType(2) * v2 - ic2eq;
+
+        return m0 * v0 + m1 * v1 + m2 * v2;
+    }
+
+    SampleType processLowPass(SampleType v0, SampleType g, SampleType k) { return processSample(v0, g, k, 0, 0, 1); }
+    SampleType processHighPass(SampleType v0, SampleType g, SampleType k) { return processSample(v0, g, k, 1, -k, -1); }
+};
+
+// Low cut, peak and high cut built from SVF sections. Parameter changes are smoothed per
+// sample: the smoothed values are worked out once per block in prepareBlock(), then each
+// channel runs through processChannel(), which is safe to call from several threads at once.
+template <typename SampleType>
+class StateVariableEngine
+{
+public:
+    static constexpr int maxCutSections = Butterworth::maxSections;
+
+    void prepare(double newSampleRate, int maximumBlockSize, int numChannels)
+    {
+        sampleRate = newSampleRate;
+
+        for (auto *value : {&lowCutG, &peakG, &highCutG, &peakA})
+        {
+            value->reset(sampleRate, smoothingTimeSeconds);
+        }
+
+        peakQuality.reset(sampleRate, smoothingTimeSeconds);
+
+        for (auto *buffer : {&lowCutGBuffer, &peakGBuffer, &peakKBuffer, &peakM1Buffer, &highCutGBuffer})
+        {
+            buffer->assign((size_t)maximumBlockSize, 0);
+        }
+
+        for (auto *band : {&lowCut, &highCut})
+        {
+            for (auto &mix : band->mix)
+                mix.reset(sampleRate, smoothingTimeSeconds);
+
+            for (auto &buffer : band->mixBuffers)
+                buffer.assign((size_t)maximumBlockSize, 0);
+        }
+
+        channels.assign((size_t)numChannels, ChannelState{});
+        isFirstUpdate = true;
+    }
+
+    void reset()
+    {
+        for (auto &channel : channels)
+        {
+            for (auto &section : channel.lowCut)
+                section.reset();
+
+            channel.peak.reset();
+
+            for (auto &section : channel.highCut)
+                section.reset();
+        }
+    }
+
+    // Changing the slope keeps the state of the sections still in use, and fades the ones
+    // coming or going in and out by mixing them with their input, as does switching a cut
+    // on or off, so none of that clicks
+    void setLowCut(bool enabled, SampleType frequency, int order)
+    {
+        setCut(lowCut, lowCutG, enabled, frequency, order);
+    }
+
+    void setHighCut(bool enabled, SampleType frequency, int order)
+    {
+        setCut(highCut, highCutG, enabled, frequency, order);
+    }
+
+    // Switching the bell off fades it to 0 dB over the smoothing time before it's dropped, and
+    // switching it back on fades it in from 0 dB with fresh state, so neither clicks
+    void setPeak(bool enabled, SampleType frequency, SampleType quality, SampleType gainInDecibels)
+    {
+        if (enabled && !peakActive)
+        {
+            for (auto &channel : channels)
+                channel.peak.reset();
+
+            peakA.setCurrentAndTargetValue(1);
+            peakActive = true;
+        }
+
+        peakEnabled = enabled;
+
+        setTarget(peakG, getG(frequency));
+        setTarget(peakA, enabled ? (SampleType)std::pow(10.0, gainInDecibels / 40.0) : SampleType(1));
+        setTarget(peakQuality, quality);
+    }
+
+    // Call after the setters, once the first settings of a new session are in
+    void finishUpdate()
+    {
+        isFirstUpdate = false;
+    }
+
+    // Jumps every smoothed value to its target and drops whatever was fading out. The smoothers
+    // only move in prepareBlock(), so after a spell of not being used the engine would
+    // otherwise ramp from wherever it stopped.
+    void skipSmoothing()
+    {
+        for (auto *value : {&lowCutG, &peakG, &highCutG, &peakA})
+            value->setCurrentAndTargetValue(value->getTargetValue());
+
+        peakQuality.setCurrentAndTargetValue(peakQuality.getTargetValue());
+        peakActive = peakEnabled;
+
+        for (auto *band : {&lowCut, &highCut})
+        {
+            for (auto &mix : band->mix)
+                mix.setCurrentAndTargetValue(mix.getTargetValue());
+
+            band->numSections = band->numActiveSections;
+        }
+    }
+
+    // Advances the smoothers and fills the per-sample coefficient buffers
+    void prepareBlock(int numSamples)
+    {
+        jassert(numSamples <= (int)lowCutGBuffer.size());
+
+        // Once the previous block finished fading the bell out, it has nothing left to do
+        if (!peakEnabled && !peakA.isSmoothing())
+            peakActive = false;
+
+        prepareCut(lowCut, numSamples);
+        prepareCut(highCut, numSamples);
+
+        fillBuffer(lowCutG, lowCutGBuffer, numSamples);
+        fillBuffer(highCutG, highCutGBuffer, numSamples);
+        fillBuffer(peakG, peakGBuffer, numSamples);
+
+        // Bell: k = 1 / (Q * A), m1 = k * (A^2 - 1)
+        if (peakA.isSmoothing() || peakQuality.isSmoothing())
+        {
+            for (int i = 0; i < numSamples; i++)
+            {
+                auto a = peakA.getNextValue();
+                auto k = SampleType(1) / (peakQuality.getNextValue() * a);
+
+                peakKBuffer[(size_t)i] = k;
+                peakM1Buffer[(size_t)i] = k * (a * a - SampleType(1));
+            }
+        }
+        else
+        {
+            auto a = peakA.getTargetValue();
+            auto k = SampleType(1) / (peakQuality.getTargetValue() * a);
+
+            std::fill(peakKBuffer.begin(), peakKBuffer.begin() + numSamples, k);
+            std::fill(peakM1Buffer.begin(), peakM1Buffer.begin() + numSamples, k * (a * a - SampleType(1)));
+        }
+    }
+
+    void processChannel(SampleType *data, int channel, int numSamples)
+    {
+        auto &state = channels[(size_t)channel];
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            auto x = data[i];
+
+            for (int s = 0; s < lowCut.numSections; s++)
+            {
+                auto y = state.lowCut[(size_t)s].processHighPass(x, lowCutGBuffer[(size_t)i], lowCut.k[(size_t)s]);
+                x = lowCut.mixSection(s, i, x, y);
+            }
+
+            if (peakActive)
+            {
+                x = state.peak.processSample(x, peakGBuffer[(size_t)i], peakKBuffer[(size_t)i], 1, peakM1Buffer[(size_t)i], 0);
+            }
+
+            for (int s = 0; s < highCut.numSections; s++)
+            {
+                auto y = state.highCut[(size_t)s].processLowPass(x, highCutGBuffer[(size_t)i], highCut.k[(size_t)s]);
+                x = highCut.mixSection(s, i, x, y);
+            }
+
+            data[i] = x;
+        }
+    }
+
+    int getNumChannels() const { return (int)channels.size(); }
+
+private:
+    static constexpr double smoothingTimeSeconds = 0.02;
+
+    struct CutBand
+    {
+        // Sections run, which includes any still fading out, and sections the slope uses
+        int numSections = 0;
+        int numActiveSections = 0;
+        std::array<SampleType, maxCutSections> k{};
+
+        // How much of each section's output is used, the rest being its input
+        std::array<juce::SmoothedValue<SampleType>, maxCutSections> mix;
+        std::array<std::vector<SampleType>, maxCutSections> mixBuffers;
+        std::array<bool, maxCutSections> isMixed{};
+
+        SampleType mixSection(int section, int index, SampleType input, SampleType output) const
+        {
+            if (!isMixed[(size_t)section])
+                return output;
+
+            return input + mixBuffers[(size_t)section][(size_t)index] * (output - input);
+        }
+    };
+
+    struct ChannelState
+    {
+        std::array<SvfSection<SampleType>, maxCutSections> lowCut;
+        SvfSection<SampleType> peak;
+        std::array<SvfSection<SampleType>, maxCutSections> highCut;
+    };
+
+    // g is smoothed multiplicatively, which follows a log-frequency sweep everywhere but
+    // right next to Nyquist, and saves a tan() per sample
+    using MultiplicativeValue = juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Multiplicative>;
+
+    double sampleRate = 44100.0;
+    bool isFirstUpdate = true;
+
+    CutBand lowCut, highCut;
+    bool peakEnabled = false;
+
+    // Still true while a disabled bell fades out
+    bool peakActive = false;
+
+    MultiplicativeValue lowCutG, peakG, highCutG, peakA;
+    juce::SmoothedValue<SampleType> peakQuality;
+
+    std::vector<SampleType> lowCutGBuffer, peakGBuffer, peakKBuffer, peakM1Buffer, highCutGBuffer;
+    std::vector<ChannelState> channels;
+
+    // Kept just below Nyquist, where tan() blows up
+    SampleType getG(SampleType frequency) const
+    {
+        auto clamped = juce::jlimit(1.0, Butterworth::maxFrequencyRatio * sampleRate, (double)frequency);
+
+        return (SampleType)std::tan(juce::MathConstants<double>::pi * clamped / sampleRate);
+    }
+
+    template <typename ValueType>
+    void setTarget(ValueType &value, SampleType target)
+    {
+        if (isFirstUpdate)
+            value.setCurrentAndTargetValue(target);
+        else
+            value.setTargetValue(target);
+    }
+
+    void setCut(CutBand &band, MultiplicativeValue &g, bool enabled, SampleType frequency, int order)
+    {
+        auto numSections = enabled ? juce::jlimit(0, maxCutSections, order / 2) : 0;
+
+        if (numSections != band.numActiveSections)
+        {
+            auto sections = (&band == &lowCut) ? &ChannelState::lowCut : &ChannelState::highCut;
+
+            // Only sections that weren't running start from silence, the rest carry on
+            for (auto &channel : channels)
+            {
+                for (int s = band.numSections; s < numSections; s++)
+                    (channel.*sections)[(size_t)s].reset();
+            }
+
+            // Sections on their way out keep their damping until they're gone
+            for (int s = 0; s < numSections; s++)
+            {
+                band.k[(size_t)s] = (SampleType)Butterworth::getDamping(order, s);
+            }
+
+            band.numActiveSections = numSections;
+            band.numSections = juce::jmax(band.numSections, numSections);
+        }
+
+        for (int s = 0; s < maxCutSections; s++)
+        {
+            setTarget(band.mix[(size_t)s], s < numSections ? SampleType(1) : SampleType(0));
+        }
+
+        setTarget(g, getG(frequency));
+    }
+
+    static void prepareCut(CutBand &band, int numSamples)
+    {
+        // Sections that have finished fading out have nothing left to do
+        while (band.numSections > band.numActiveSections && !band.mix[(size_t)band.numSections - 1].isSmoothing())
+            band.numSections--;
+
+        for (int s = 0; s < band.numSections; s++)
+        {
+            auto &mix = band.mix[(size_t)s];
+            auto &buffer = band.mixBuffers[(size_t)s];
+
+            band.isMixed[(size_t)s] = mix.isSmoothing() || mix.getTargetValue() < SampleType(1);
+
+            if (!band.isMixed[(size_t)s])
+                continue;
+
+            if (mix.isSmoothing())
+            {
+                for (int i = 0; i < numSamples; i++)
+                    buffer[(size_t)i] = mix.getNextValue();
+            }
+            else
+            {
+                std::fill(buffer.begin(), buffer.begin() + numSamples, mix.getTargetValue());
+            }
+        }
+    }
+
+    static void fillBuffer(MultiplicativeValue &value, std::vector<SampleType> &buffer, int numSamples)
+    {
+        if (value.isSmoothing())
+        {
+            for (int i = 0; i < numSamples; i++)
+                buffer[(size_t)i] = value.getNextValue();
+        }
+        else
+        {
+            std::fill(buffer.begin(), buffer.begin() + numSamples, value.getTargetValue());
+        }
+    }
+};
@@ -0,0 +1,256 @@
+#include "Tracing.h"
+#include "AnalyzerWorkerPool.h"
+#include "RealtimeGuard.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#if JUCE_WINDOWS
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Tracing
+{
+namespace
+{
+struct Event
+{
+    const char *name;
+    juce::int64 startTicks, endTicks;
+};
+
+// Written by its own thread only. When it wraps, the oldest events are overwritten.
+struct ThreadBuffer
+{
+    static constexpr juce::uint64 capacity = 1 << 15;
+
+    std::array<Event, capacity> events;
+    std::atomic<juce::uint64> numWritten{0};
+
+    juce::String threadName;
+    int threadId = 0;
+
+    void push(const Event &event)
+    {
+        auto index = numWritten.load(std::memory_order_relaxed);
+        events[index % capacity] = event;
+        numWritten.store(index + 1, std::memory_order_release);
+    }
+
+    // Only touched by the Writer
+    juce::uint64 numCollected = 0;
+    bool isNamed = false;
+
+    // Copies out what's been pushed since the last call, less whatever the writer overwrote
+    // before we got to it or while we were reading
+    void collect(std::vector<Event> &destination)
+    {
+        auto end = numWritten.load(std::memory_order_acquire);
+        auto start = juce::jmax(numCollected, end > capacity ? end - capacity : 0);
+
+        auto firstCopied = destination.size();
+
+        for (auto i = start; i < end; i++)
+            destination.push_back(events[i % capacity]);
+
+        // Anything the writer got to in the meantime is torn, so drop it
+        auto endAfterCopy = numWritten.load(std::memory_order_acquire);
+        auto firstValid = endAfterCopy > capacity ? endAfterCopy - capacity : 0;
+
+        if (firstValid > start)
+        {
+            auto numTorn = (size_t)juce::jmin(firstValid - start, end - start);
+            destination.erase(destination.begin() + (std::ptrdiff_t)firstCopied,
+                              destination.begin() + (std::ptrdiff_t)(firstCopied + numTorn));
+        }
+
+        numCollected = end;
+    }
+};
+
+// Buffers are never freed, so events from threads that have finished are still written out
+struct Registry
+{
+    juce::CriticalSection lock;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry &getRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+thread_local ThreadBuffer *threadBuffer = nullptr;
+
+ThreadBuffer &getThreadBuffer()
+{
+    if (threadBuffer == nullptr)
+    {
+        // Once per thread, the first traced block on the audio thread pays for it
+        RealtimeGuard::ScopedAllowance allowance;
+
+        auto &registry = getRegistry();
+        auto buffer = std::make_unique<ThreadBuffer>();
+
+        const juce::ScopedLock sl(registry.lock);
+
+        buffer->threadId = (int)registry.buffers.size() + 1;
+        buffer->threadName = juce::Thread::getCurrentThreadName();
+
+        // Host threads, the message thread included, don't have a juce::Thread name
+        if (buffer->threadName.isEmpty())
+            buffer->threadName = "Thread " + juce::String(buffer->threadId);
+
+        threadBuffer = buffer.get();
+        registry.buffers.push_back(std::move(buffer));
+    }
+
+    return *threadBuffer;
+}
+
+double ticksToMicroseconds(juce::int64 ticks)
+{
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+}
+
+int getProcessId()
+{
+#if JUCE_WINDOWS
+    return (int)_getpid();
+#else
+    return (int)getpid();
+#endif
+}
+} // namespace
+
+ScopedEvent::ScopedEvent(const char *eventName) : name(eventName),
+                                                  startTicks(juce::Time::getHighResolutionTicks())
+{
+}
+
+ScopedEvent::~ScopedEvent()
+{
+    getThreadBuffer().push({name, startTicks, juce::Time::getHighResolutionTicks()});
+}
+
+struct Writer::Pimpl : private AnalyzerWorkerPool::Client
+{
+    Pimpl()
+    {
+        // Several hosts can be tracing at once, and a host can load the plugin more than once
+        static std::atomic<int> instanceCounter{0};
+
+        file = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                   .getChildFile("EqualizerTrace-" + juce::String(processId) + "-" + juce::String(++instanceCounter) + ".json");
+
+        stream = std::make_unique<juce::FileOutputStream>(file);
+
+        if (!stream->openedOk())
+        {
+            stream.reset();
+            file = juce::File();
+            return;
+        }
+
+        // Left over from an earlier process that had the same pid
+        stream->setPosition(0);
+        stream->truncate();
+
+        // The JSON array format, which the viewers read with or without the closing bracket
+        *stream << "[";
+        workerPool->addClient(*this);
+    }
+
+    ~Pimpl() override
+    {
+        if (stream == nullptr)
+            return;
+
+        // Once the pool is done with us, whatever is left in the buffers is ours to write
+        workerPool->removeClient(*this);
+        writeNewEvents();
+
+        *stream << "\n]\n";
+        stream->flush();
+    }
+
+    void runAnalysisFrame() override
+    {
+        writeNewEvents();
+
+        // So a trace survives the host going down, which is often when it's wanted most
+        stream->flush();
+    }
+
+    void writeNewEvents()
+    {
+        // Threads can register while we write, so work from a copy of the list
+        {
+            auto &registry = getRegistry();
+            const juce::ScopedLock sl(registry.lock);
+
+            buffers.clear();
+
+            for (const auto &buffer : registry.buffers)
+                buffers.push_back(buffer.get());
+        }
+
+        for (auto *buffer : buffers)
+        {
+            if (!buffer->isNamed)
+            {
+                writeSeparator();
+                *stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << processId << ",\"tid\":" << buffer->threadId
+                        << ",\"args\":{\"name\":" << juce::JSON::toString(buffer->threadName) << "}}";
+
+                buffer->isNamed = true;
+            }
+
+            events.clear();
+            buffer->collect(events);
+
+            for (const auto &event : events)
+            {
+                writeSeparator();
+                *stream << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":" << processId << ",\"tid\":" << buffer->threadId
+                        << ",\"ts\":" << juce::String(ticksToMicroseconds(event.startTicks), 3)
+                        << ",\"dur\":" << juce::String(ticksToMicroseconds(event.endTicks - event.startTicks), 3) << "}";
+            }
+        }
+    }
+
+    // Separators go before each event rather than after, so the file is valid whenever it's cut off
+    void writeSeparator()
+    {
+        *stream << (isFirstEvent ? "\n" : ",\n");
+        isFirstEvent = false;
+    }
+
+    const int processId = getProcessId();
+    juce::File file;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    bool isFirstEvent = true;
+
+    std::vector<ThreadBuffer *> buffers;
+    std::vector<Event> events;
+
+    juce::SharedResourcePointer<AnalyzerWorkerPool> workerPool;
+};
+
+Writer::Writer()
+{
+    if (isCompiledIn())
+        pimpl = std::make_unique<Pimpl>();
+}
+
+Writer::~Writer() = default;
+
+juce::File Writer::getFile() const
+{
+    return pimpl != nullptr ? pimpl->file : juce::File();
+}
+} // namespace Tracing
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <atomic>
+#include <memory>
+
+// Timeline tracing for diagnosing dropouts. Built with EQUALIZER_TRACING=1 (the CMake option of
+// the same name), every EQ_TRACE_SCOPE records its start and end into a buffer owned by the
+// calling thread, and a Writer appends them to a JSON file that chrome://tracing and Perfetto
+// open. Without the flag the macro expands to nothing.
+#ifndef EQUALIZER_TRACING
+#define EQUALIZER_TRACING 0
+#endif
+
+namespace Tracing
+{
+constexpr bool isCompiledIn() { return EQUALIZER_TRACING != 0; }
+
+// 'name' must outlive the trace, in practice a string literal
+class ScopedEvent
+{
+public:
+    explicit ScopedEvent(const char *eventName);
+    ~ScopedEvent();
+
+private:
+    const char *name;
+    juce::int64 startTicks;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedEvent)
+};
+
+// While one exists, every thread's new events are appended to a file in the temp directory
+// named after the process, at the analyzer pool's frame rate, and flushed. So the trace covers
+// the whole session rather than the last few seconds, and survives a crash or a hang: the file
+// is a JSON array that's only closed when the writer goes, which the viewers don't need.
+// Share it through juce::SharedResourcePointer<Tracing::Writer>, which the processor does.
+// Does nothing unless tracing is compiled in.
+class Writer
+{
+public:
+    Writer();
+    ~Writer();
+
+    // Empty if tracing isn't compiled in or the file couldn't be opened
+    juce::File getFile() const;
+
+private:
+    struct Pimpl;
+    std::unique_ptr<Pimpl> pimpl;
+
+    JUCE_DECLARE_NON_COPYABLE(Writer)
+};
+} // namespace Tracing
+
+#if EQUALIZER_TRACING
+#define EQ_TRACE_SCOPE(name) Tracing::ScopedEvent JUCE_JOIN_MACRO(traceEvent_, __LINE__)(name)
+#else
+#define EQ_TRACE_SCOPE(name)
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../src/PluginProcessor.h"
+
+// The filter chain as it was before any of the performance work: JUCE's own IIR designs in the
+// juce::dsp::ProcessorChain, updated the way the original processBlock did it. The only change
+// is the sample type, so it can run in double. The bilinear cases of the golden files are its
+// output, so they can't move along with a change to the processor's designs or kernels.
+namespace BaselineChain
+{
+template <int Index, typename ChainType, typename CoefficientsArray>
+void updateStage(ChainType &chain, const CoefficientsArray &coefficients)
+{
+    *chain.template get<Index>().coefficients = *coefficients[Index];
+    chain.template setBypassed<Index>(false);
+}
+
+template <typename ChainType, typename CoefficientsArray>
+void updateCutFilter(ChainType &chain, const CoefficientsArray &coefficients, Slope slope)
+{
+    chain.template setBypassed<0>(true);
+    chain.template setBypassed<1>(true);
+    chain.template setBypassed<2>(true);
+    chain.template setBypassed<3>(true);
+
+    switch (slope)
+    {
+    case Slope_48:
+        updateStage<3>(chain, coefficients);
+        [[fallthrough]];
+    case Slope_36:
+        updateStage<2>(chain, coefficients);
+        [[fallthrough]];
+    case Slope_24:
+        updateStage<1>(chain, coefficients);
+        [[fallthrough]];
+    case Slope_12:
+        updateStage<0>(chain, coefficients);
+    }
+}
+
+// Filters 'samples' in place, 'blockSize' at a time
+template <typename SampleType>
+void render(const ChainSettings &chainSettings, double sampleRate, int blockSize, SampleType *samples, int numSamples)
+{
+    using Coefficients = juce::dsp::IIR::Coefficients<SampleType>;
+    using Design = juce::dsp::FilterDesign<SampleType>;
+
+    MonoChain<SampleType> chain;
+    chain.prepare({sampleRate, (juce::uint32)blockSize, 1});
+
+    auto lowCutCoefficients = Design::designIIRHighpassHighOrderButterworthMethod(
+        (SampleType)chainSettings.lowCutFreq, sampleRate, 2 * (chainSettings.lowCutSlope + 1));
+
+    chain.template setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+    updateCutFilter(chain.template get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
+
+    auto peakCoefficients = Coefficients::makePeakFilter(sampleRate, (SampleType)chainSettings.peakFreq, (SampleType)chainSettings.peakQuality,
+                                                         juce::Decibels::decibelsToGain((SampleType)chainSettings.peakGainInDecibels));
+
+    chain.template setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+    *chain.template get<ChainPositions::Peak>().coefficients = *peakCoefficients;
+
+    auto highCutCoefficients = Design::designIIRLowpassHighOrderButterworthMethod(
+        (SampleType)chainSettings.highCutFreq, sampleRate, 2 * (chainSettings.highCutSlope + 1));
+
+    chain.template setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+    updateCutFilter(chain.template get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        auto *channel = samples + start;
+        juce::dsp::AudioBlock<SampleType> block(&channel, 1, (size_t)juce::jmin(blockSize, numSamples - start));
+        chain.process(juce::dsp::ProcessContextReplacing<SampleType>(block));
+    }
+}
+} // namespace BaselineChain
@@ -0,0 +1,823 @@
+// Headless checks of the processor, run by CTest. Fixed signals go through processBlock and
+// the output is checked against:
+//
+//   - src/ReferenceCascade.h, for every combination of slopes and stage bypass at each sample
+//     rate the plugin is expected to run at, with typical and extreme settings, on both
+//     engines, both designs, with and without the coefficient bank, in float and double
+//   - golden files in tests/golden, for a handful of those renders. The bilinear ones are the
+//     output of the chain as it was before the performance work (tests/BaselineChain.h), so
+//     a change to the designs or kernels shows up even when the reference would move with it
+//   - the analog prototypes, at the points the matched designs are matched at
+//
+// and a saved state is restored into a second processor, which has to end up the same. Built
+// with the realtime guard (src/RealtimeGuard.h), it checks the guard reports a HeapBlock or
+// AudioBuffer allocation, then automates every chain parameter through thousands of blocks,
+// and processBlock must not allocate or lock in any of them.
+//
+//     EqualizerTests [--golden <directory>] [--update-golden] [--realtime]
+//
+// --update-golden rewrites the golden files instead of checking them, the bilinear cases from
+// the baseline chain and the rest from the processor; only do that for a change that's meant
+// to alter the output, and say why in its commit. --realtime runs the realtime check on
+// its own. Exits with 1 if anything fails.
+
+#include "../src/PluginProcessor.h"
+#include "../src/RealtimeGuard.h"
+#include "../src/ReferenceCascade.h"
+#include "BaselineChain.h"
+
+#include <array>
+#include <complex>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef EQUALIZER_GOLDEN_DIRECTORY
+#define EQUALIZER_GOLDEN_DIRECTORY "tests/golden"
+#endif
+
+namespace
+{
+constexpr double sampleRates[] = {44100.0, 48000.0, 88200.0, 96000.0, 192000.0};
+
+constexpr int numChannels = 2;
+constexpr int blockSize = 512;
+constexpr int numSamples = 8 * blockSize;
+
+// Largest difference from the double-precision reference, relative to the larger of 1 and
+// the reference's peak. The float biquads do worst on a Q 12 bell at 20 Hz and 192 kHz, at
+// about 2e-3; the state-variable sections stay within about 5e-6, double within 1e-11.
+constexpr double floatBiquadTolerance = 1.0e-2;
+constexpr double floatStateVariableTolerance = 1.0e-4;
+constexpr double doubleTolerance = 1.0e-9;
+
+// Golden renders are double precision; this leaves room for the kernel variant and compiler,
+// not for a different design
+constexpr double goldenTolerance = 1.0e-7;
+constexpr int goldenDecimation = 16;
+
+// The matched designs hit their analog prototypes exactly at these points, up to rounding and
+// the impulse response being cut off
+constexpr double matchedToleranceInDecibels = 0.01;
+
+// Blocks of automation per precision and coefficient bank setting in the realtime check
+constexpr int numStressBlocks = 4000;
+
+struct Setting
+{
+    const char *name;
+    float lowCutFreq, peakFreq, peakQuality, peakGainInDecibels, highCutFreq;
+};
+
+// The extremes are the ends of the parameter ranges: the narrowest, loudest bell near either
+// end of the spectrum, the widest deepest one, and cuts right at 20 Hz and 20 kHz
+constexpr Setting settings[] = {
+    {"typical", 80.0f, 1000.0f, 1.0f, 6.0f, 12000.0f},
+    {"narrow-high", 20.0f, 18000.0f, 12.0f, 24.0f, 20000.0f},
+    {"narrow-low", 20.0f, 20.0f, 12.0f, 24.0f, 20000.0f},
+    {"wide-cut", 2000.0f, 200.0f, 0.2f, -24.0f, 4000.0f},
+    {"neutral-peak", 500.0f, 1000.0f, 1.0f, 0.0f, 5000.0f},
+};
+
+struct Mode
+{
+    const char *name;
+    FilterEngine engine;
+    FilterDesign design;
+    bool coefficientBank;
+};
+
+constexpr Mode modes[] = {
+    {"bilinear", FilterEngine::Biquad, FilterDesign::Bilinear, false},
+    {"bilinear-bank", FilterEngine::Biquad, FilterDesign::Bilinear, true},
+    {"matched", FilterEngine::Biquad, FilterDesign::Matched, false},
+    {"state-variable", FilterEngine::StateVariable, FilterDesign::Bilinear, false},
+};
+
+// Bits of a bypass mask, set for the stages that are on
+constexpr int lowCutOn = 1, peakOn = 2, highCutOn = 4;
+constexpr int allOn = lowCutOn | peakOn | highCutOn;
+
+struct Case
+{
+    const Setting *setting;
+    const Mode *mode;
+    int lowCutSlope, highCutSlope, mask;
+
+    juce::String getName() const
+    {
+        return juce::String(setting->name) + "-" + mode->name + "-" + juce::String(12 * (lowCutSlope + 1)) + "-" +
+               juce::String(12 * (highCutSlope + 1)) + "-" + juce::String(mask);
+    }
+};
+
+// Every rate gets these in its golden file
+const std::vector<Case> goldenCases = {
+    {&settings[0], &modes[0], 1, 3, allOn},
+    {&settings[1], &modes[0], 3, 3, allOn},
+    {&settings[3], &modes[0], 0, 0, allOn},
+    {&settings[2], &modes[0], 3, 3, allOn},
+    {&settings[0], &modes[0], 0, 2, peakOn},
+    {&settings[0], &modes[0], 2, 0, lowCutOn | highCutOn},
+    {&settings[0], &modes[3], 1, 3, allOn},
+    {&settings[2], &modes[3], 3, 3, allOn},
+    {&settings[0], &modes[2], 3, 1, allOn},
+    {&settings[1], &modes[2], 3, 3, allOn},
+};
+
+// The only mode the chain had before the performance work
+bool isBaselineCase(const Case &c)
+{
+    return c.mode == &modes[0];
+}
+
+using Render = std::array<std::vector<double>, numChannels>;
+
+// White noise at about -17 dBFS RMS from a fixed LCG, a different sequence on each channel, so
+// it's the same on every platform and never silent
+Render makeInput()
+{
+    Render input;
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        auto state = (juce::uint32)(channel + 1);
+        input[(size_t)channel].resize((size_t)numSamples);
+
+        for (auto &sample : input[(size_t)channel])
+        {
+            state = state * 1664525u + 1013904223u;
+            sample = ((double)(state >> 8) / 8388608.0 - 1.0) * 0.25;
+        }
+    }
+
+    return input;
+}
+
+Render makeImpulse()
+{
+    Render input;
+
+    for (auto &channel : input)
+        channel.assign((size_t)numSamples, 0.0);
+
+    for (auto &channel : input)
+        channel[0] = 1.0;
+
+    return input;
+}
+
+struct Results
+{
+    int numPassed = 0;
+    int numFailed = 0;
+
+    void check(bool passed, const juce::String &description)
+    {
+        if (passed)
+        {
+            numPassed++;
+            return;
+        }
+
+        numFailed++;
+        std::printf("FAILED  %s\n", description.toRawUTF8());
+    }
+};
+
+void setParameter(AudioPluginAudioProcessor &processor, const juce::String &id, float value)
+{
+    auto *parameter = processor.apvts.getParameter(id);
+    jassert(parameter != nullptr);
+
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+void applyCase(AudioPluginAudioProcessor &processor, const Case &c)
+{
+    setParameter(processor, "Low Cut Freq", c.setting->lowCutFreq);
+    setParameter(processor, "High Cut Freq", c.setting->highCutFreq);
+    setParameter(processor, "Peak Freq", c.setting->peakFreq);
+    setParameter(processor, "Peak Gain", c.setting->peakGainInDecibels);
+    setParameter(processor, "Peak Quality", c.setting->peakQuality);
+    setParameter(processor, "Low Cut Slope", (float)c.lowCutSlope);
+    setParameter(processor, "High Cut Slope", (float)c.highCutSlope);
+    setParameter(processor, "Low Cut Bypassed", (c.mask & lowCutOn) != 0 ? 0.0f : 1.0f);
+    setParameter(processor, "Peak Bypassed", (c.mask & peakOn) != 0 ? 0.0f : 1.0f);
+    setParameter(processor, "High Cut Bypassed", (c.mask & highCutOn) != 0 ? 0.0f : 1.0f);
+    setParameter(processor, "Filter Engine", (float)c.mode->engine);
+    setParameter(processor, "Filter Design", (float)c.mode->design);
+
+    processor.setCoefficientBankEnabled(c.mode->coefficientBank);
+}
+
+// A fresh start at 'sampleRate', as a host would after changing it
+void prepare(AudioPluginAudioProcessor &processor, double sampleRate, bool doublePrecision)
+{
+    processor.releaseResources();
+    processor.setProcessingPrecision(doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                     : juce::AudioProcessor::singlePrecision);
+    processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+}
+
+template <typename SampleType>
+Render render(AudioPluginAudioProcessor &processor, const Render &input)
+{
+    juce::AudioBuffer<SampleType> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    Render output;
+
+    for (auto &channel : output)
+        channel.resize((size_t)numSamples);
+
+    for (int offset = 0; offset < numSamples; offset += blockSize)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            for (int i = 0; i < blockSize; i++)
+                buffer.setSample(channel, i, (SampleType)input[(size_t)channel][(size_t)(offset + i)]);
+        }
+
+        processor.processBlock(buffer, midi);
+
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            for (int i = 0; i < blockSize; i++)
+                output[(size_t)channel][(size_t)(offset + i)] = (double)buffer.getSample(channel, i);
+        }
+    }
+
+    return output;
+}
+
+Render render(AudioPluginAudioProcessor &processor, const Render &input, bool doublePrecision)
+{
+    return doublePrecision ? render<double>(processor, input) : render<float>(processor, input);
+}
+
+// ReferenceCascade only has the bilinear designs. For the matched ones it runs the production
+// design in double precision, which still checks everything from there on; the designs
+// themselves are checked against the analog prototypes by checkMatchedDesigns().
+void renderMatchedReference(const ChainSettings &chainSettings, double sampleRate, std::vector<double> &samples)
+{
+    std::vector<ReferenceCascade::Section> sections;
+
+    auto add = [&sections](const double *c)
+    { sections.push_back(ReferenceCascade::makeSection(c[0], c[1], c[2], 1.0, c[3], c[4])); };
+
+    auto addCut = [&add, sampleRate](float frequency, Slope slope, bool isHighPass)
+    {
+        std::array<std::array<double, 5>, Butterworth::maxSections> cut{};
+        std::array<double *, Butterworth::maxSections> pointers{cut[0].data(), cut[1].data(), cut[2].data(), cut[3].data()};
+
+        MatchedEQ::designCut(pointers.data(), 2 * (slope + 1), frequency, sampleRate, isHighPass);
+
+        for (int s = 0; s <= (int)slope; s++)
+            add(cut[(size_t)s].data());
+    };
+
+    if (!chainSettings.lowCutBypassed)
+        addCut(chainSettings.lowCutFreq, chainSettings.lowCutSlope, true);
+
+    if (!chainSettings.peakBypassed)
+    {
+        double peak[5];
+        MatchedEQ::designPeak(peak, chainSettings.peakFreq, sampleRate, chainSettings.peakQuality,
+                              chainSettings.peakGainInDecibels);
+        add(peak);
+    }
+
+    if (!chainSettings.highCutBypassed)
+        addCut(chainSettings.highCutFreq, chainSettings.highCutSlope, false);
+
+    for (auto &sample : samples)
+    {
+        for (auto &section : sections)
+            sample = section.process(sample);
+    }
+}
+
+Render renderReference(const ChainSettings &chainSettings, double sampleRate, Render samples)
+{
+    for (auto &channel : samples)
+    {
+        if (getEffectiveDesign(chainSettings) == FilterDesign::Matched)
+            renderMatchedReference(chainSettings, sampleRate, channel);
+        else
+            ReferenceCascade::render(chainSettings, sampleRate, channel.data(), numSamples);
+    }
+
+    return samples;
+}
+
+double getPeak(const Render &samples)
+{
+    double peak = 0.0;
+
+    for (const auto &channel : samples)
+    {
+        for (auto sample : channel)
+            peak = juce::jmax(peak, std::abs(sample));
+    }
+
+    return peak;
+}
+
+double getMaxDifference(const Render &a, const Render &b)
+{
+    double difference = 0.0;
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        difference = juce::jmax(difference, ReferenceCascade::getMaxDifference(a[(size_t)channel].data(),
+                                                                               b[(size_t)channel].data(), numSamples));
+    }
+
+    return difference;
+}
+
+void checkAgainstReference(Results &results)
+{
+    AudioPluginAudioProcessor processor;
+    auto input = makeInput();
+
+    for (const auto &mode : modes)
+    {
+        for (const auto &setting : settings)
+        {
+            for (auto sampleRate : sampleRates)
+            {
+                for (int lowCutSlope = 0; lowCutSlope < 4; lowCutSlope++)
+                {
+                    for (int highCutSlope = 0; highCutSlope < 4; highCutSlope++)
+                    {
+                        for (int mask = 0; mask <= allOn; mask++)
+                        {
+                            Case c{&setting, &mode, lowCutSlope, highCutSlope, mask};
+                            applyCase(processor, c);
+
+                            auto reference = renderReference(getChainSettings(processor.apvts), sampleRate, input);
+                            auto scale = juce::jmax(1.0, getPeak(reference));
+
+                            for (auto doublePrecision : {false, true})
+                            {
+                                prepare(processor, sampleRate, doublePrecision);
+                                auto output = render(processor, input, doublePrecision);
+
+                                auto tolerance = doublePrecision                              ? doubleTolerance
+                                                 : mode.engine == FilterEngine::StateVariable ? floatStateVariableTolerance
+                                                                                              : floatBiquadTolerance;
+                                auto error = getMaxDifference(output, reference) / scale;
+
+                                results.check(error <= tolerance,
+                                              "reference " + c.getName() + (doublePrecision ? " double" : " float") + " at " +
+                                                  juce::String(sampleRate) + " Hz: off by " + juce::String(error) +
+                                                  ", tolerance " + juce::String(tolerance));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+juce::File getGoldenFile(const juce::File &directory, double sampleRate)
+{
+    return directory.getChildFile(juce::String((int)sampleRate) + ".txt");
+}
+
+// Each case is its name on a line of its own, then its samples, eight to a line; '#' starts a
+// comment
+std::map<juce::String, std::vector<double>> readGoldenFile(const juce::File &file)
+{
+    std::map<juce::String, std::vector<double>> golden;
+    std::vector<double> *samples = nullptr;
+
+    for (const auto &line : juce::StringArray::fromLines(file.loadFileAsString()))
+    {
+        auto trimmed = line.trim();
+
+        if (trimmed.isEmpty() || trimmed.startsWithChar('#'))
+            continue;
+
+        if (juce::CharacterFunctions::isLetter(trimmed[0]))
+        {
+            samples = &golden[trimmed];
+            continue;
+        }
+
+        if (samples == nullptr)
+            continue;
+
+        for (const auto &token : juce::StringArray::fromTokens(trimmed, false))
+            samples->push_back(token.getDoubleValue());
+    }
+
+    return golden;
+}
+
+std::vector<double> getGoldenSamples(const Render &output)
+{
+    std::vector<double> samples;
+
+    for (int i = 0; i < numSamples; i += goldenDecimation)
+        samples.push_back(output[0][(size_t)i]);
+
+    return samples;
+}
+
+// The bilinear cases were written from the baseline chain, which the processor has to keep
+// matching. The others are the processor's own output as of the change that added them.
+void checkGolden(Results &results, const juce::File &directory, bool update)
+{
+    AudioPluginAudioProcessor processor;
+    auto input = makeInput();
+
+    for (auto sampleRate : sampleRates)
+    {
+        auto file = getGoldenFile(directory, sampleRate);
+        auto golden = update ? std::map<juce::String, std::vector<double>>() : readGoldenFile(file);
+
+        juce::String text;
+        text << "# Golden output of tests/EqualizerTests.cpp at " << (int)sampleRate << " Hz: every "
+             << goldenDecimation << "th sample of the\n# left channel, in double precision. The bilinear "
+             << "cases come from the chain as it was before\n# the performance work (tests/BaselineChain.h); "
+             << "see checkGolden().\n";
+
+        for (const auto &c : goldenCases)
+        {
+            applyCase(processor, c);
+            prepare(processor, sampleRate, true);
+
+            auto samples = getGoldenSamples(render(processor, input, true));
+            auto name = c.getName();
+
+            if (update)
+            {
+                if (isBaselineCase(c))
+                {
+                    auto baseline = input[0];
+                    BaselineChain::render(getChainSettings(processor.apvts), sampleRate, blockSize, baseline.data(), numSamples);
+                    samples = getGoldenSamples({baseline, input[1]});
+                }
+
+                text << "\n" << name << "\n";
+
+                for (size_t i = 0; i < samples.size(); i++)
+                    text << juce::String(samples[i], 12) << ((i % 8 == 7) ? "\n" : " ");
+
+                continue;
+            }
+
+            auto found = golden.find(name);
+
+            if (found == golden.end() || found->second.size() != samples.size())
+            {
+                results.check(false, "golden " + name + " at " + juce::String(sampleRate) + " Hz: missing from " +
+                                         file.getFullPathName());
+                continue;
+            }
+
+            double error = 0.0;
+
+            for (size_t i = 0; i < samples.size(); i++)
+                error = juce::jmax(error, std::abs(samples[i] - found->second[i]) / juce::jmax(1.0, std::abs(found->second[i])));
+
+            results.check(error <= goldenTolerance, "golden " + name + " at " + juce::String(sampleRate) + " Hz: off by " +
+                                                        juce::String(error) + ", tolerance " + juce::String(goldenTolerance));
+        }
+
+        if (update)
+        {
+            results.check(file.replaceWithText(text), "writing " + file.getFullPathName());
+            std::printf("Wrote %s\n", file.getFullPathName().toRawUTF8());
+        }
+    }
+}
+
+// Magnitude of the response at 'frequency', from its impulse response
+double getMagnitudeInDecibels(const std::vector<double> &impulseResponse, double frequency, double sampleRate)
+{
+    std::complex<double> sum;
+    auto w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+    for (size_t n = 0; n < impulseResponse.size(); n++)
+        sum += impulseResponse[n] * std::polar(1.0, -w * (double)n);
+
+    return juce::Decibels::gainToDecibels(std::abs(sum), -400.0);
+}
+
+// The cookbook bell, (s^2 + s A / Q + 1) / (s^2 + s / (A Q) + 1), at 'frequency'
+double getAnalogPeakInDecibels(double frequency, const Setting &setting)
+{
+    auto A = std::pow(10.0, setting.peakGainInDecibels / 40.0);
+    auto w = frequency / setting.peakFreq;
+    auto real = (1.0 - w * w) * (1.0 - w * w);
+    auto numerator = real + std::pow(w * A / setting.peakQuality, 2.0);
+    auto denominator = real + std::pow(w / (A * setting.peakQuality), 2.0);
+
+    return 10.0 * std::log10(numerator / denominator);
+}
+
+void checkMatchedDesigns(Results &results)
+{
+    AudioPluginAudioProcessor processor;
+    auto impulse = makeImpulse();
+
+    // High enough that the bilinear designs are visibly squeezed at 44.1 kHz
+    const Setting setting{"matched", 15000.0f, 16000.0f, 2.0f, 12.0f, 15000.0f};
+    const Mode &matched = modes[2];
+    const Mode &bilinear = modes[0];
+
+    auto getImpulseResponse = [&processor, &impulse](const Case &c, double sampleRate)
+    {
+        applyCase(processor, c);
+        prepare(processor, sampleRate, true);
+        return render(processor, impulse, true)[0];
+    };
+
+    auto expectNear = [&results](double actual, double expected, const juce::String &description)
+    {
+        results.check(std::abs(actual - expected) <= matchedToleranceInDecibels,
+                      description + ": " + juce::String(actual, 4) + " dB, expected " + juce::String(expected, 4) + " dB");
+    };
+
+    for (auto sampleRate : sampleRates)
+    {
+        auto at = " at " + juce::String(sampleRate) + " Hz";
+        auto nyquist = sampleRate / 2.0;
+
+        // The bell alone: matched at DC and at the centre, where it's also at its highest
+        auto peak = getImpulseResponse({&setting, &matched, 0, 0, peakOn}, sampleRate);
+        auto centre = getMagnitudeInDecibels(peak, setting.peakFreq, sampleRate);
+
+        expectNear(getMagnitudeInDecibels(peak, 0.0, sampleRate), 0.0, "matched bell at DC" + at);
+        expectNear(centre, setting.peakGainInDecibels, "matched bell at its centre" + at);
+
+        results.check(getMagnitudeInDecibels(peak, 0.999 * setting.peakFreq, sampleRate) < centre &&
+                          getMagnitudeInDecibels(peak, 1.001 * setting.peakFreq, sampleRate) < centre,
+                      "matched bell peaks at its centre" + at);
+
+        // Above the centre it should be nearer the analog bell than the bilinear one is
+        auto bilinearPeak = getImpulseResponse({&setting, &bilinear, 0, 0, peakOn}, sampleRate);
+        auto high = 0.95 * nyquist;
+        auto analog = getAnalogPeakInDecibels(high, setting);
+
+        results.check(std::abs(getMagnitudeInDecibels(peak, high, sampleRate) - analog) <
+                          std::abs(getMagnitudeInDecibels(bilinearPeak, high, sampleRate) - analog),
+                      "matched bell nearer the analog one than bilinear near Nyquist" + at);
+
+        // Butterworth cuts are 3.01 dB down at the cutoff whatever the order; the low-pass is
+        // matched at DC as well
+        auto highCut = getImpulseResponse({&setting, &matched, 0, 3, highCutOn}, sampleRate);
+        auto lowCut = getImpulseResponse({&setting, &matched, 3, 0, lowCutOn}, sampleRate);
+        auto halfPower = juce::Decibels::gainToDecibels(std::sqrt(0.5));
+
+        expectNear(getMagnitudeInDecibels(highCut, 0.0, sampleRate), 0.0, "matched high cut at DC" + at);
+        expectNear(getMagnitudeInDecibels(highCut, setting.highCutFreq, sampleRate), halfPower,
+                   "matched high cut at its cutoff" + at);
+        expectNear(getMagnitudeInDecibels(lowCut, setting.lowCutFreq, sampleRate), halfPower,
+                   "matched low cut at its cutoff" + at);
+    }
+}
+
+void checkStateRoundTrip(Results &results)
+{
+    AudioPluginAudioProcessor source;
+    AudioPluginAudioProcessor restored;
+
+    // Everything but the cut bypasses is off its default in the source, and those start out on
+    // in the one being restored, so a parameter that isn't restored can't pass by accident
+    const Setting setting{"state", 120.0f, 2500.0f, 3.5f, -7.5f, 9000.0f};
+
+    applyCase(source, {&setting, &modes[3], 2, 1, lowCutOn | highCutOn});
+    setParameter(source, "Filter Design", (float)FilterDesign::Matched);
+    setParameter(source, "Analyzer Smoothing", 2.0f);
+
+    setParameter(restored, "Low Cut Bypassed", 1.0f);
+    setParameter(restored, "High Cut Bypassed", 1.0f);
+
+    auto ids = getChainParameterIDs();
+    ids.add("Analyzer Smoothing");
+
+    auto getValue = [](AudioPluginAudioProcessor &processor, const juce::String &id)
+    { return processor.apvts.getRawParameterValue(id)->load(); };
+
+    for (const auto &id : ids)
+    {
+        results.check(getValue(source, id) != getValue(restored, id), "state round trip: \"" + id + "\" starts out different");
+    }
+
+    juce::MemoryBlock state;
+    source.getStateInformation(state);
+    restored.setStateInformation(state.getData(), (int)state.getSize());
+
+    for (const auto &id : ids)
+    {
+        results.check(getValue(source, id) == getValue(restored, id), "state round trip: \"" + id + "\" restored");
+    }
+
+    // Same settings, so the same output to the last bit
+    auto input = makeInput();
+
+    for (auto doublePrecision : {false, true})
+    {
+        prepare(source, 48000.0, doublePrecision);
+        prepare(restored, 48000.0, doublePrecision);
+
+        results.check(getMaxDifference(render(source, input, doublePrecision), render(restored, input, doublePrecision)) == 0.0,
+                      juce::String("state round trip: same output in ") + (doublePrecision ? "double" : "float"));
+    }
+
+    // Anything that isn't a saved state is ignored
+    const char nonsense[] = "not a state";
+    restored.setStateInformation(nonsense, (int)sizeof(nonsense));
+
+    for (const auto &id : ids)
+    {
+        results.check(getValue(source, id) == getValue(restored, id), "state round trip: \"" + id + "\" kept after an invalid state");
+    }
+}
+
+// Written to after each allocation below, so the optimiser can't drop any of them as unused
+void *volatile allocationSink = nullptr;
+
+// The guard has to see what processBlock would actually do wrong. JUCE's containers allocate
+// through malloc rather than new, and AudioBuffer::setSize is the usual way one gets in.
+void checkGuardReportsViolations(Results &results)
+{
+    RealtimeGuard::setAction(RealtimeGuard::Action::Report);
+
+    auto expectReported = [&results](const char *what, auto &&function)
+    {
+        auto numViolationsBefore = RealtimeGuard::getNumViolations();
+
+        {
+            RealtimeGuard::ScopedRealtimeSection realtimeSection;
+            function();
+        }
+
+        results.check(RealtimeGuard::getNumViolations() > numViolationsBefore,
+                      juce::String("realtime guard: ") + what + " wasn't reported");
+    };
+
+    struct alignas(64) OverAligned
+    {
+        float values[16];
+    };
+
+    juce::HeapBlock<float> heapBlock;
+    juce::AudioBuffer<float> buffer(numChannels, 16);
+    std::unique_ptr<OverAligned> overAligned;
+    std::mutex mutex;
+
+    auto growHeapBlock = [&]
+    {
+        heapBlock.malloc(4096);
+        allocationSink = heapBlock.get();
+    };
+
+    auto growBuffer = [&]
+    {
+        buffer.setSize(numChannels, 4096);
+        allocationSink = buffer.getWritePointer(0);
+    };
+
+    auto newOverAligned = [&]
+    {
+        overAligned = std::make_unique<OverAligned>();
+        allocationSink = overAligned.get();
+    };
+
+    expectReported("over-aligned new", newOverAligned);
+
+    // Only seen where malloc and pthread_mutex_lock can be wrapped
+    if (RealtimeGuard::interposesLibc())
+    {
+        expectReported("HeapBlock::malloc", growHeapBlock);
+        expectReported("AudioBuffer::setSize", growBuffer);
+        expectReported("free", [&] { heapBlock.free(); });
+        expectReported("mutex lock", [&] { const std::lock_guard<std::mutex> lock(mutex); });
+    }
+}
+
+template <typename SampleType>
+void runAutomationStress(AudioPluginAudioProcessor &processor, const Render &input)
+{
+    juce::AudioBuffer<SampleType> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+
+    std::vector<juce::RangedAudioParameter *> parameters;
+
+    for (const auto &id : getChainParameterIDs())
+        parameters.push_back(processor.apvts.getParameter(id));
+
+    for (int block = 0; block < numStressBlocks; block++)
+    {
+        // Every chain parameter moves on every block, each at its own rate, so the slopes,
+        // bypasses, engine and design keep switching while the frequencies, gain and Q sweep
+        for (size_t i = 0; i < parameters.size(); i++)
+            parameters[i]->setValueNotifyingHost((float)std::fmod((block + 1) * (0.013 + 0.007 * (double)i), 1.0));
+
+        // Hosts don't always keep to the maximum they prepared with
+        auto blockLength = 1 + (block * 97) % blockSize;
+        buffer.setSize(numChannels, blockLength, false, false, true);
+
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            for (int i = 0; i < blockLength; i++)
+                buffer.setSample(channel, i, (SampleType)input[(size_t)channel][(size_t)((block * blockSize + i) % numSamples)]);
+        }
+
+        processor.processBlock(buffer, midi);
+    }
+}
+
+void checkRealtimeSafety(Results &results)
+{
+    // A violation stops the run with its stack trace, which is the useful part
+    RealtimeGuard::setAction(RealtimeGuard::Action::Abort);
+    auto numViolationsBefore = RealtimeGuard::getNumViolations();
+
+    AudioPluginAudioProcessor processor;
+    auto input = makeInput();
+
+    for (auto doublePrecision : {false, true})
+    {
+        for (auto coefficientBank : {false, true})
+        {
+            processor.setCoefficientBankEnabled(coefficientBank);
+            prepare(processor, 48000.0, doublePrecision);
+
+            if (doublePrecision)
+                runAutomationStress<double>(processor, input);
+            else
+                runAutomationStress<float>(processor, input);
+        }
+    }
+
+    results.check(RealtimeGuard::getNumViolations() == numViolationsBefore,
+                  "realtime safety: " + juce::String(RealtimeGuard::getNumViolations() - numViolationsBefore) +
+                      " allocations or locks in processBlock");
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; i++)
+        args.add(argv[i]);
+
+    auto update = args.contains("--update-golden");
+    auto goldenIndex = args.indexOf("--golden");
+    auto goldenDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(
+        goldenIndex >= 0 ? args[goldenIndex + 1] : juce::String(EQUALIZER_GOLDEN_DIRECTORY));
+
+    Results results;
+
+    if (update)
+    {
+        goldenDirectory.createDirectory();
+        checkGolden(results, goldenDirectory, true);
+        return results.numFailed > 0 ? 1 : 0;
+    }
+
+    auto run = [&results](const char *name, auto &&test)
+    {
+        auto numFailedBefore = results.numFailed;
+        auto startTicks = juce::Time::getHighResolutionTicks();
+
+        test();
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        std::printf("%-20s %s (%.1f s)\n", name, results.numFailed == numFailedBefore ? "passed" : "FAILED", seconds);
+    };
+
+    if (!args.contains("--realtime"))
+    {
+        run("reference", [&results] { checkAgainstReference(results); });
+        run("golden", [&results, &goldenDirectory] { checkGolden(results, goldenDirectory, false); });
+        run("matched designs", [&results] { checkMatchedDesigns(results); });
+        run("state round trip", [&results] { checkStateRoundTrip(results); });
+    }
+
+    if (RealtimeGuard::isCompiledIn())
+    {
+        run("realtime guard", [&results] { checkGuardReportsViolations(results); });
+        run("realtime safety", [&results] { checkRealtimeSafety(results); });
+    }
+    else
+    {
+        std::printf("%-20s skipped, needs EQUALIZER_REALTIME_GUARD\n", "realtime safety");
+    }
+
+    std::printf("%d checks passed, %d failed\n", results.numPassed, results.numFailed);
+    return results.numFailed > 0 ? 1 : 0;
+}
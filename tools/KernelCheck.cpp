@@ -0,0 +1,173 @@
+// Checks the filter cascade kernels (src/Kernels.h) against src/ReferenceCascade.h and times
+// them, for every variant this CPU runs. The cascade is the worst case the processor has:
+// 48 dB/oct on both cuts with the peak in between, nine sections, which is also the most the
+// fixed-count form is built for.
+//
+//     EqualizerKernelCheck [seconds of audio, default 60]
+//
+// Errors are the largest absolute difference from the double-precision reference over the
+// whole run, on white noise at -10 dBFS RMS, fed through in 512 sample blocks.
+//
+// It builds the kernels on their own, without JUCE, so the CPU check is done here with the
+// compiler's builtins rather than by Kernels.cpp.
+
+#include "../src/Kernels.h"
+#include "../src/ReferenceCascade.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace Kernels::baseline
+{
+constexpr int vectorBytes = 16;
+#include "../src/KernelImplementation.h"
+} // namespace Kernels::baseline
+
+#if EQUALIZER_X86_KERNELS
+namespace Kernels
+{
+const Table &getAVX2Table();
+const Table &getAVX512Table();
+} // namespace Kernels
+#endif
+
+namespace
+{
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 512;
+
+std::vector<ReferenceCascade::Section> makeWorstCase()
+{
+    std::vector<ReferenceCascade::Section> sections;
+
+    for (int k = 0; k < 4; k++)
+        sections.push_back(ReferenceCascade::makeCutSection(80.0, sampleRate, 8, k, true));
+
+    sections.push_back(ReferenceCascade::makePeakSection(1000.0, sampleRate, 1.0, 6.0));
+
+    for (int k = 0; k < 4; k++)
+        sections.push_back(ReferenceCascade::makeCutSection(8000.0, sampleRate, 8, k, false));
+
+    return sections;
+}
+
+struct Result
+{
+    double maxError = 0.0;
+    double nanosecondsPerSample = 0.0;
+};
+
+template <typename SampleType, typename Function>
+Result run(Function function, const std::vector<ReferenceCascade::Section> &design,
+           const std::vector<double> &input, const std::vector<double> &expected)
+{
+    auto numSections = (int)design.size();
+
+    std::vector<SampleType> state((size_t)(2 * numSections), 0);
+    std::vector<Kernels::BiquadSection<SampleType>> sections;
+
+    for (int s = 0; s < numSections; s++)
+    {
+        const auto &d = design[(size_t)s];
+        sections.push_back({(SampleType)d.b0, (SampleType)d.b1, (SampleType)d.b2, (SampleType)d.a1, (SampleType)d.a2,
+                            state.data() + 2 * s});
+    }
+
+    std::vector<SampleType> samples(input.begin(), input.end());
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t n = 0; n + blockSize <= samples.size(); n += blockSize)
+        function(samples.data() + n, blockSize, sections.data(), numSections);
+
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Result result;
+    result.nanosecondsPerSample = seconds * 1.0e9 / (double)samples.size();
+
+    for (size_t i = 0; i < samples.size(); i++)
+        result.maxError = std::max(result.maxError, std::abs((double)samples[i] - expected[i]));
+
+    return result;
+}
+
+void check(const char *name, const Kernels::Table &table, const std::vector<ReferenceCascade::Section> &design,
+           const std::vector<double> &input, const std::vector<double> &expected)
+{
+    auto print = [name](const char *form, const char *type, const Result &result)
+    {
+        std::printf("%-8s  %-13s  %-6s  %9.2e  %7.2f ns/sample\n", name, form, type, result.maxError, result.nanosecondsPerSample);
+    };
+
+    // The worst case is exactly as many sections as the fixed cascades go up to
+    auto fixedFloat = [&table](float *samples, int numSamples, const Kernels::BiquadSection<float> *sections, int)
+    { table.processFixedCascadeFloat[Kernels::maxFixedSections](samples, numSamples, sections); };
+
+    auto fixedDouble = [&table](double *samples, int numSamples, const Kernels::BiquadSection<double> *sections, int)
+    { table.processFixedCascadeDouble[Kernels::maxFixedSections](samples, numSamples, sections); };
+
+    print("serial", "float", run<float>(table.processCascadeFloat, design, input, expected));
+    print("time-parallel", "float", run<float>(table.processCascadeTimeParallelFloat, design, input, expected));
+    print("fixed", "float", run<float>(fixedFloat, design, input, expected));
+    print("serial", "double", run<double>(table.processCascadeDouble, design, input, expected));
+    print("time-parallel", "double", run<double>(table.processCascadeTimeParallelDouble, design, input, expected));
+    print("fixed", "double", run<double>(fixedDouble, design, input, expected));
+
+    auto getPick = [](bool fixedIsFaster, bool timeParallelIsFaster)
+    { return fixedIsFaster ? "fixed" : timeParallelIsFaster ? "time-parallel" : "serial"; };
+
+    std::printf("%-8s  picks %s for float, %s for double\n", name,
+                getPick(table.fixedIsFasterFloat, table.timeParallelIsFasterFloat),
+                getPick(table.fixedIsFasterDouble, table.timeParallelIsFasterDouble));
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    auto seconds = argc > 1 ? std::atof(argv[1]) : 60.0;
+    auto numSamples = (size_t)std::max(1.0, seconds * sampleRate / blockSize) * blockSize;
+
+    auto design = makeWorstCase();
+
+    std::vector<double> input(numSamples);
+    std::mt19937 random(1);
+    std::normal_distribution<double> noise(0.0, 0.316);
+
+    for (auto &sample : input)
+        sample = noise(random);
+
+    auto expected = input;
+
+    {
+        auto reference = design;
+
+        for (auto &sample : expected)
+        {
+            for (auto &section : reference)
+                sample = section.process(sample);
+        }
+    }
+
+    std::printf("variant   form           type    max error  time\n");
+
+    static constexpr auto baselineTable = Kernels::baseline::makeTable(Kernels::Variant::baseline);
+    check("baseline", baselineTable, design, input, expected);
+
+#if EQUALIZER_X86_KERNELS
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        check("avx2", Kernels::getAVX2Table(), design, input, expected);
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+        __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("fma"))
+        check("avx512", Kernels::getAVX512Table(), design, input, expected);
+#endif
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Reference reader for the shared-memory export (src/SharedMonitorLayout.h). Maps an
+// instance's block read-only and prints its level and a coarse spectrum a few times a second.
+//
+//     EqualizerMonitorReader /eqplugin-<pid>-<instance>
+//
+// On Linux, running it without a name lists the instances found in /dev/shm.
+//
+// Instances only export when asked to. Start the host with EQUALIZER_SHARED_MONITOR=1 in its
+// environment and every instance it loads publishes a block, or call
+// AnalysisEngine::setSharedMemoryExportEnabled() from code.
+
+#include "../src/SharedMonitorLayout.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr int numBands = 10;
+
+void listInstances()
+{
+    if (auto *dir = opendir("/dev/shm"))
+    {
+        while (auto *entry = readdir(dir))
+        {
+            if (std::strncmp(entry->d_name, SharedMonitor::namePrefix, std::strlen(SharedMonitor::namePrefix)) == 0)
+                std::printf("/%s\n", entry->d_name);
+        }
+
+        closedir(dir);
+    }
+}
+
+// Reads the newest frame in place. Returns false if the writer was in the middle of it.
+bool readLatest(const SharedMonitor::Header &header, std::uint64_t &frameIndex, double &sampleRate,
+                float &peak, float &rms, float (&bands)[numBands])
+{
+    auto count = header.writeCount.load(std::memory_order_acquire);
+
+    if (count == 0)
+        return false;
+
+    const auto &frame = header.frames[(count - 1) % SharedMonitor::ringSize];
+
+    auto before = frame.sequence.load(std::memory_order_acquire);
+
+    if ((before & 1) != 0)
+        return false;
+
+    frameIndex = frame.frameIndex;
+    sampleRate = frame.sampleRate;
+    peak = frame.peakDecibels;
+    rms = frame.rmsDecibels;
+
+    // Loudest bin in each band, bands evenly spaced in log frequency from 20 Hz to 20 kHz
+    auto numBins = (int)std::min<std::uint32_t>(frame.numBins, SharedMonitor::maxBins);
+    auto binWidth = numBins > 0 ? sampleRate / (2.0 * numBins) : 1.0;
+
+    for (int b = 0; b < numBands; b++)
+    {
+        auto low = 20.0 * std::pow(1000.0, (double)b / numBands);
+        auto high = 20.0 * std::pow(1000.0, (double)(b + 1) / numBands);
+
+        bands[b] = -100.0f;
+
+        for (auto bin = (int)(low / binWidth); bin < numBins && bin * binWidth < high; bin++)
+            bands[b] = std::max(bands[b], frame.spectrumDecibels[bin]);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return frame.sequence.load(std::memory_order_relaxed) == before;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::printf("Usage: %s <shared memory name>\n", argv[0]);
+        listInstances();
+        return 1;
+    }
+
+    auto fd = shm_open(argv[1], O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        std::perror("shm_open");
+        return 1;
+    }
+
+    auto *memory = mmap(nullptr, SharedMonitor::getBlockSize(), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (memory == MAP_FAILED)
+    {
+        std::perror("mmap");
+        return 1;
+    }
+
+    const auto &header = *static_cast<const SharedMonitor::Header *>(memory);
+
+    if (header.magic != SharedMonitor::magic || header.version != SharedMonitor::version ||
+        header.frameSize != sizeof(SharedMonitor::Frame) || header.numFrames != (std::uint32_t)SharedMonitor::ringSize)
+    {
+        std::fprintf(stderr, "%s isn't a version %u monitor block\n", argv[1], SharedMonitor::version);
+        return 1;
+    }
+
+    std::uint64_t lastFrameIndex = 0;
+
+    for (;;)
+    {
+        std::uint64_t frameIndex = 0;
+        double sampleRate = 0;
+        float peak = 0, rms = 0;
+        float bands[numBands];
+
+        if (readLatest(header, frameIndex, sampleRate, peak, rms, bands) && frameIndex != lastFrameIndex)
+        {
+            std::printf("#%llu  %.0f Hz  peak %6.1f dB  rms %6.1f dB  |",
+                        (unsigned long long)frameIndex, sampleRate, peak, rms);
+
+            for (auto band : bands)
+                std::printf(" %4.0f", band);
+
+            std::printf("\n");
+            std::fflush(stdout);
+
+            lastFrameIndex = frameIndex;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
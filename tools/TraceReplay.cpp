@@ -0,0 +1,195 @@
+// Replays an automation trace (src/AutomationTrace.h) through the processor, without a host or
+// GUI, and times every processBlock. The input is white noise from a fixed seed, so the
+// filters always have something to do and runs can be compared with each other.
+//
+//     EqualizerTraceReplay <trace> [--repeat <n>]
+//
+// Prints how long blocks took and how much faster than real time the whole trace ran.
+
+#include "../src/PluginProcessor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+struct Replay
+{
+    AudioPluginAudioProcessor processor;
+    std::vector<juce::RangedAudioParameter *> parameters;
+
+    juce::AudioBuffer<float> floatBuffer;
+    juce::AudioBuffer<double> doubleBuffer;
+    juce::MidiBuffer midi;
+    juce::Random random{1};
+
+    bool prepared = false;
+    double sampleRate = 0.0;
+
+    std::vector<double> blockMicroseconds;
+    double audioSeconds = 0.0;
+    int numSkippedBlocks = 0;
+
+    void prepare(const AutomationTrace::Event &event)
+    {
+        prepared = event.sampleRate > 0.0 && event.maximumBlockSize > 0 && event.numChannels > 0;
+
+        if (!prepared)
+            return;
+
+        sampleRate = event.sampleRate;
+
+        processor.releaseResources();
+        processor.setProcessingPrecision(event.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                               : juce::AudioProcessor::singlePrecision);
+        processor.setPlayConfigDetails(event.numChannels, event.numChannels, event.sampleRate, event.maximumBlockSize);
+        processor.prepareToPlay(event.sampleRate, event.maximumBlockSize);
+
+        floatBuffer.setSize(event.numChannels, event.maximumBlockSize);
+        doubleBuffer.setSize(event.numChannels, event.maximumBlockSize);
+    }
+
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType> &buffer, int numSamples)
+    {
+        // Hosts don't always keep to the maximum they prepared with
+        buffer.setSize(buffer.getNumChannels(), numSamples, false, false, true);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+        {
+            auto *samples = buffer.getWritePointer(channel);
+
+            for (int i = 0; i < numSamples; i++)
+                samples[i] = (SampleType)(0.25f * (2.0f * random.nextFloat() - 1.0f));
+        }
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        processor.processBlock(buffer, midi);
+        auto endTicks = juce::Time::getHighResolutionTicks();
+
+        blockMicroseconds.push_back(1.0e6 * juce::Time::highResolutionTicksToSeconds(endTicks - startTicks));
+    }
+
+    void processBlock(const AutomationTrace::Event &event)
+    {
+        if (!prepared)
+        {
+            numSkippedBlocks++;
+            return;
+        }
+
+        // The values go in the same way host automation does, through the parameters
+        for (size_t i = 0; i < parameters.size(); i++)
+        {
+            if (auto *parameter = parameters[i])
+                parameter->setValueNotifyingHost(parameter->convertTo0to1(event.values[i]));
+        }
+
+        if (processor.isUsingDoublePrecision())
+            process(doubleBuffer, event.numSamples);
+        else
+            process(floatBuffer, event.numSamples);
+
+        audioSeconds += event.numSamples / sampleRate;
+    }
+
+    bool run(const juce::File &file)
+    {
+        AutomationTrace::Reader reader;
+
+        if (!reader.open(file))
+            return false;
+
+        parameters.clear();
+
+        for (const auto &id : reader.getParameterIDs())
+        {
+            parameters.push_back(processor.apvts.getParameter(id));
+
+            if (parameters.back() == nullptr)
+                std::fprintf(stderr, "Ignoring unknown parameter \"%s\"\n", id.toRawUTF8());
+        }
+
+        AutomationTrace::Event event;
+
+        while (reader.readNext(event))
+        {
+            if (event.type == AutomationTrace::Event::prepare)
+                prepare(event);
+            else
+                processBlock(event);
+        }
+
+        return true;
+    }
+
+    void printSummary() const
+    {
+        if (blockMicroseconds.empty())
+        {
+            std::printf("No blocks replayed\n");
+            return;
+        }
+
+        auto sorted = blockMicroseconds;
+        std::sort(sorted.begin(), sorted.end());
+
+        double totalMicroseconds = 0.0;
+
+        for (auto microseconds : sorted)
+            totalMicroseconds += microseconds;
+
+        auto percentile = [&sorted](int percent)
+        { return sorted[(sorted.size() - 1) * (size_t)percent / 100]; };
+
+        std::printf("Blocks        %zu (%d skipped before the first prepare)\n", sorted.size(), numSkippedBlocks);
+        std::printf("Audio         %.3f s\n", audioSeconds);
+        std::printf("Processing    %.3f s, %.1fx real time\n", totalMicroseconds * 1.0e-6,
+                    audioSeconds / juce::jmax(1.0e-9, totalMicroseconds * 1.0e-6));
+        std::printf("Per block     mean %.2f us, median %.2f us, 99%% %.2f us, max %.2f us\n",
+                    totalMicroseconds / (double)sorted.size(), percentile(50), percentile(99), sorted.back());
+    }
+};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; i++)
+        args.add(argv[i]);
+
+    auto repeatIndex = args.indexOf("--repeat");
+    auto numRepeats = 1;
+
+    if (repeatIndex >= 0)
+    {
+        numRepeats = juce::jmax(1, args[repeatIndex + 1].getIntValue());
+        args.removeRange(repeatIndex, 2);
+    }
+
+    if (args.size() != 1)
+    {
+        std::fprintf(stderr, "Usage: EqualizerTraceReplay <trace> [--repeat <n>]\n");
+        return 2;
+    }
+
+    auto file = juce::File::getCurrentWorkingDirectory().getChildFile(args[0]);
+
+    Replay replay;
+
+    for (int i = 0; i < numRepeats; i++)
+    {
+        if (!replay.run(file))
+        {
+            std::fprintf(stderr, "Couldn't read a trace from %s\n", file.getFullPathName().toRawUTF8());
+            return 1;
+        }
+    }
+
+    replay.printSummary();
+    return 0;
+}